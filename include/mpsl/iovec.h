@@ -44,6 +44,29 @@ namespace mpsl{
         return {{ make_iovec(args)... }};
     }
 
+    //byte size make_iovec yields for T when it is known at compile time (pods), 0 when only known at runtime (sequences, iovecs)
+    template<typename T, typename = void>
+    struct static_iovec_size : std::integral_constant<size_t, 0>{};
+
+    template<typename T>
+    struct static_iovec_size<T, typename std::enable_if< !(has_data_method<T>::value && has_size_method<T>::value) &&
+        std::is_standard_layout<T>::value && !std::is_same<T, struct iovec>::value>::type> : std::integral_constant<size_t, sizeof(T)>{};
+
+    template<typename Arg>
+    struct static_iovec_arg_size : static_iovec_size<typename std::remove_cv<typename std::remove_reference<Arg>::type>::type>{};
+
+    //sum over a make_iovec_array argument pack, 0 unless every element is statically sized
+    template<class... Args>
+    struct static_iovec_nbytes;
+
+    template<>
+    struct static_iovec_nbytes<> : std::integral_constant<size_t, 0>{};
+
+    template<class Arg, class... Args>
+    struct static_iovec_nbytes<Arg, Args...> : std::integral_constant<size_t,
+        static_iovec_arg_size<Arg>::value == 0 || (sizeof...(Args) != 0 && static_iovec_nbytes<Args...>::value == 0) ? 0 :
+        static_iovec_arg_size<Arg>::value + static_iovec_nbytes<Args...>::value>{};
+
     inline size_t iovec_nbytes(const iovec *v, int nelem){
         size_t sum = 0;
         for(int i = 0; i < nelem; ++i){
@@ -52,6 +75,12 @@ namespace mpsl{
         return sum;
     }
 
+    //total of an array built by make_iovec_array(Args...), folded to a constant when the pack is all pods
+    template<class... Args>
+    inline size_t iovec_array_nbytes(const std::array<struct iovec, sizeof...(Args)> &iov){
+        return static_iovec_nbytes<Args...>::value != 0 ? static_iovec_nbytes<Args...>::value : iovec_nbytes(iov.data(), (int) iov.size());
+    }
+
     //(iterator, iov_remainder, iov_sum_inclusive) - it is head + iov_count when not enough bytes exist
     inline std::tuple<iovec *, size_t, size_t> iovec_advance(iovec *head, size_t iov_count, size_t nbytes, size_t offset = 0){
         size_t sum = 0;
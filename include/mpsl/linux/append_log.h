@@ -0,0 +1,234 @@
+#ifndef MPSL_LINUX_APPEND_LOG
+#define MPSL_LINUX_APPEND_LOG
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "mpsl/posix.h"
+
+//append only log: preallocated with fallocate, positional writes from any thread, one fdatasync per group of appenders
+namespace mpsl{
+
+    struct AppendLogOptions{
+        off_t preallocate_bytes;//the file is grown in steps of this size ahead of the append position, 0 disables
+        off_t writeback_bytes;//start async writeback (sync_file_range) each time this much new data is written, 0 disables
+        inline AppendLogOptions(): preallocate_bytes(off_t(64) << 20), writeback_bytes(off_t(1) << 20){}
+    };
+
+    //appends reserve [offset, offset + length) under the lock and write outside it, so writes complete out of order;
+    //written_end only moves over contiguous completed ranges and is what a sync can make durable
+    struct AppendLog{
+        int fd;
+        AppendLogOptions options;
+        std::mutex mutex;
+        std::condition_variable cv;
+        off_t end;//next append offset
+        off_t allocated;//file size after preallocation
+        off_t written_end;//every byte below is written to the page cache
+        off_t durable_end;//every byte below is on stable storage
+        off_t writeback_end;//writeback has been started for every byte below
+        bool syncing;//a group leader is inside fdatasync
+        int error;//first failed append, written_end can never pass the hole it left
+        int sync_error;//first failed fdatasync, the page cache state is unknown so every later sync fails too
+        std::map<off_t, off_t> completed;//out of order finished writes above written_end, offset -> end
+        inline AppendLog(): fd(-1), options(), end(0), allocated(0), written_end(0), durable_end(0), writeback_end(0), syncing(false), error(0), sync_error(0){}
+        AppendLog(const AppendLog &) = delete;
+        AppendLog &operator=(const AppendLog &) = delete;
+    };
+
+    struct AppendResult : public WriteResult{
+        off_t offset;//where the record starts
+        off_t lsn;//where it ends, pass to append_log_sync to wait for durability
+        inline AppendResult():WriteResult(), offset(0), lsn(0){}
+        inline AppendResult(bool success, int errnum, size_t nwritten, off_t offset, off_t lsn): WriteResult(success, errnum, nwritten), offset(offset), lsn(lsn){}
+    };
+
+    //fd must be writable, appends start at start_offset (usually the logical end found by recovery)
+    inline BaseResult append_log_open(AppendLog &log, int fd, off_t start_offset, const AppendLogOptions &options = AppendLogOptions()){
+        struct stat st;
+        if(::fstat(fd, &st) != 0){
+            return BaseResult(false, errno);
+        }
+        log.fd = fd;
+        log.options = options;
+        log.end = log.written_end = log.durable_end = log.writeback_end = start_offset;
+        log.allocated = st.st_size;
+        log.syncing = false;
+        log.error = 0;
+        log.sync_error = 0;
+        log.completed.clear();
+        return BaseResult(true, 0);
+    }
+
+    //opens or creates path and appends after its current size. after an unclean shutdown that size still includes the
+    //preallocated zero tail, recover the logical end and use the fd overload instead
+    inline BaseResult append_log_open(AppendLog &log, const char *path, const AppendLogOptions &options = AppendLogOptions()){
+        OpenResult opened = open(path, O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+        if(!opened){
+            return opened;
+        }
+        struct stat st;
+        if(::fstat(*opened, &st) != 0){
+            const int lerrno = errno;
+            close(*opened);
+            return BaseResult(false, lerrno);
+        }
+        return append_log_open(log, *opened, st.st_size, options);
+    }
+
+    //caller holds log.mutex; fallocate without KEEP_SIZE so appends inside the preallocated region never change i_size
+    inline BaseResult append_log_reserve(AppendLog &log, off_t needed_end){
+        if(needed_end <= log.allocated || log.options.preallocate_bytes <= 0){
+            return BaseResult(true, 0);
+        }
+        const off_t step = log.options.preallocate_bytes;
+        const off_t new_allocated = (needed_end + step - 1) / step * step;
+        int ret;
+        do{
+            ret = ::fallocate(log.fd, 0, log.allocated, new_allocated - log.allocated);
+        }while(ret == -1 && errno == EINTR);
+        if(ret != 0){
+            const int lerrno = errno;
+            if(lerrno != EOPNOTSUPP){
+                return BaseResult(false, lerrno);
+            }
+            log.options.preallocate_bytes = 0;//filesystem cannot preallocate, plain appends from now on
+        }else{
+            log.allocated = new_allocated;
+        }
+        return BaseResult(true, 0);
+    }
+
+    //caller holds log.mutex
+    inline void append_log_complete(AppendLog &log, off_t offset, off_t record_end){
+        if(record_end == offset){
+            return;
+        }
+        if(offset != log.written_end){
+            log.completed[offset] = record_end;
+            return;
+        }
+        log.written_end = record_end;
+        for(auto it = log.completed.begin(); it != log.completed.end() && it->first == log.written_end; it = log.completed.erase(it)){
+            log.written_end = it->second;
+        }
+    }
+
+    //writes one record made of iov, safe to call from many threads. the record is in the page cache when this returns,
+    //use append_log_sync(result.lsn) for durability
+    inline AppendResult append_log_appendv(AppendLog &log, const struct iovec *iov, size_t iovcnt){
+        const size_t length = iovec_nbytes(iov, (int) iovcnt);
+        off_t offset;
+        {
+            std::lock_guard<std::mutex> lock(log.mutex);
+            if(length == 0){//nothing to write or complete, an empty range would share its key in completed with the next record
+                return AppendResult(true, 0, 0, log.end, log.end);
+            }
+            BaseResult reserved = append_log_reserve(log, log.end + (off_t) length);
+            if(!reserved){
+                return AppendResult(false, reserved.code().value(), 0, log.end, log.end);
+            }
+            offset = log.end;
+            log.end += (off_t) length;
+        }
+
+        std::vector<struct iovec> iov_copy(iov, iov + iovcnt);
+        IOVecWriteResult written = write_all_inplace_at(log.fd, iov_copy.data(), iovcnt, offset);
+
+        off_t writeback_from = 0, writeback_to = 0;
+        {
+            std::lock_guard<std::mutex> lock(log.mutex);
+            if(written){
+                append_log_complete(log, offset, offset + (off_t) length);
+                if(log.options.writeback_bytes > 0 && log.written_end - log.writeback_end >= log.options.writeback_bytes){
+                    writeback_from = log.writeback_end;
+                    writeback_to = log.written_end;
+                    log.writeback_end = log.written_end;
+                }
+            }else if(log.error == 0){
+                log.error = written.code().value() ? written.code().value() : EIO;
+            }
+            log.cv.notify_all();
+        }
+        if(writeback_to > writeback_from){//overlap writeback of older data with new appends, fdatasync later finds it clean
+            ::sync_file_range(log.fd, writeback_from, writeback_to - writeback_from, SYNC_FILE_RANGE_WRITE);
+        }
+        return AppendResult(written.success, written.code().value(), written.nwritten, offset, offset + (off_t) length);
+    }
+
+    template<typename... Args>
+    inline AppendResult append_log_append(AppendLog &log, Args&&... pods){
+        auto buffers = make_iovec_array(std::forward<Args>(pods)...);
+        return append_log_appendv(log, buffers.data(), buffers.size());
+    }
+
+    //blocks until everything up to lsn is durable. one caller becomes the leader and issues fdatasync for all
+    //bytes written so far, the others wait for it (or for the next round) - concurrent appenders share one sync.
+    //a failed fdatasync poisons the log: after it, retrying could report success for pages the kernel already dropped
+    inline BaseResult append_log_sync(AppendLog &log, off_t lsn){
+        std::unique_lock<std::mutex> lock(log.mutex);
+        for(;;){
+            if(log.sync_error != 0){
+                return BaseResult(false, log.sync_error);
+            }
+            if(log.durable_end >= lsn){
+                return BaseResult(true, 0);
+            }
+            if(log.written_end < lsn && log.error != 0){
+                return BaseResult(false, log.error);
+            }
+            if(log.syncing || log.written_end < lsn){
+                log.cv.wait(lock);
+                continue;
+            }
+            log.syncing = true;
+            const off_t target = log.written_end;
+            lock.unlock();
+            int ret;
+            do{
+                ret = ::fdatasync(log.fd);
+            }while(ret == -1 && errno == EINTR);
+            const int lerrno = ret == 0 ? 0 : errno;
+            lock.lock();
+            log.syncing = false;
+            if(ret == 0){
+                log.durable_end = std::max(log.durable_end, target);
+            }else if(log.sync_error == 0){
+                log.sync_error = lerrno ? lerrno : EIO;
+            }
+            log.cv.notify_all();
+        }
+    }
+
+    inline AppendResult append_log_appendv_durable(AppendLog &log, const struct iovec *iov, size_t iovcnt){
+        AppendResult result = append_log_appendv(log, iov, iovcnt);
+        if(!result){
+            return result;
+        }
+        BaseResult synced = append_log_sync(log, result.lsn);
+        return AppendResult(synced.success, synced.code().value(), result.nwritten, result.offset, result.lsn);
+    }
+
+    //syncs, trims the preallocated tail back to the logical end and closes the fd
+    inline BaseResult append_log_close(AppendLog &log){
+        BaseResult synced = append_log_sync(log, log.end);
+        int lerrno = synced ? 0 : synced.code().value();
+        if(::ftruncate(log.fd, log.end) != 0 && lerrno == 0){
+            lerrno = errno;
+        }
+        CloseResult closed = close(log.fd);
+        if(!closed && lerrno == 0){
+            lerrno = closed.code().value();
+        }
+        log.fd = -1;
+        return BaseResult(lerrno == 0, lerrno);
+    }
+}
+
+#endif
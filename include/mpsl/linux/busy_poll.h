@@ -0,0 +1,111 @@
+#ifndef MPSL_LINUX_BUSY_POLL
+#define MPSL_LINUX_BUSY_POLL
+
+#include <poll.h>
+
+#include <cstdint>
+
+#include "mpsl/socket.h"
+#include "mpsl/time.h"
+
+//low latency receive: kernel busy polling plus user space spin-then-block on recvmsg
+namespace mpsl{
+
+    struct BusyPollOptions{
+        int busy_poll_usecs;//SO_BUSY_POLL, raising it above net.core.busy_read needs CAP_NET_ADMIN
+        bool prefer_busy_poll;//SO_PREFER_BUSY_POLL (5.11+), defers softirq processing to the polling thread
+        int busy_poll_budget;//SO_BUSY_POLL_BUDGET (5.11+), 0 keeps the kernel default
+        inline BusyPollOptions(): busy_poll_usecs(50), prefer_busy_poll(true), busy_poll_budget(0){}
+    };
+
+    //first failing option is reported, options the running headers do not know about are skipped
+    inline SetSockOptResult set_busy_poll(int sockfd, const BusyPollOptions &options){
+        SetSockOptResult result = setsockopt(sockfd, SOL_SOCKET, SO_BUSY_POLL, options.busy_poll_usecs);
+        if(!result){
+            return result;
+        }
+#ifdef SO_PREFER_BUSY_POLL
+        if(options.prefer_busy_poll){
+            result = setsockopt(sockfd, SOL_SOCKET, SO_PREFER_BUSY_POLL, int(1));
+            if(!result){
+                return result;
+            }
+        }
+#endif
+#ifdef SO_BUSY_POLL_BUDGET
+        if(options.busy_poll_budget > 0){
+            result = setsockopt(sockfd, SOL_SOCKET, SO_BUSY_POLL_BUDGET, options.busy_poll_budget);
+        }
+#endif
+        return result;
+    }
+
+    struct SpinThenBlockPolicy{
+        uint64_t spin_nanos;//how long to spin on non-blocking recvmsg before sleeping in poll
+        int block_timeout_millis;//poll timeout once spinning gave up, -1 waits forever
+        inline SpinThenBlockPolicy(): spin_nanos(20000), block_timeout_millis(-1){}
+        inline SpinThenBlockPolicy(uint64_t spin_nanos, int block_timeout_millis): spin_nanos(spin_nanos), block_timeout_millis(block_timeout_millis){}
+    };
+
+    //per feed counters, not synchronized - keep one per receiving thread
+    struct SpinThenBlockStats{
+        uint64_t spin_hits;//messages found while spinning
+        uint64_t blocking_wakeups;//messages received after sleeping in poll
+        uint64_t timeouts;//poll timed out with nothing to read
+        uint64_t spin_attempts;//non-blocking recvmsg calls that came back empty
+        inline SpinThenBlockStats(): spin_hits(0), blocking_wakeups(0), timeouts(0), spin_attempts(0){}
+        inline double spin_hit_ratio() const{
+            const uint64_t total = spin_hits + blocking_wakeups;
+            return total ? double(spin_hits) / double(total) : 0.0;
+        }
+    };
+
+    //spins with MSG_DONTWAIT for policy.spin_nanos, then blocks in poll and reads once readable.
+    //a poll timeout comes back as would_block(), any other failure as the recvmsg/poll error
+    inline RecvMsgResult recvmsgv_spin_then_block(int fd, int flags, struct iovec *iov, const size_t iovcnt, const SpinThenBlockPolicy &policy, SpinThenBlockStats &stats){
+        const int nonblocking_flags = flags | MSG_DONTWAIT;
+        const uint64_t deadline = clock_gettime(CLOCK_MONOTONIC).nanos() + policy.spin_nanos;
+        for(;;){
+            RecvMsgResult result = recvmsgv(fd, nonblocking_flags, iov, iovcnt);
+            if(result){
+                stats.spin_hits++;
+                return result;
+            }else if(!result.would_block() && result != EINTR){
+                return result;
+            }
+            stats.spin_attempts++;
+            if(clock_gettime(CLOCK_MONOTONIC).nanos() >= deadline){
+                break;
+            }
+        }
+        for(;;){
+            struct pollfd pfd = {fd, POLLIN, 0};
+            const int ready = ::poll(&pfd, 1, policy.block_timeout_millis);
+            if(ready == -1){
+                const int lerrno = errno;
+                if(lerrno == EINTR){
+                    continue;
+                }
+                return RecvMsgResult(false, lerrno, iovec_nbytes(iov, iovcnt), 0, {}, 0, 0, 0);
+            }else if(ready == 0){
+                stats.timeouts++;
+                return RecvMsgResult(false, EAGAIN, iovec_nbytes(iov, iovcnt), 0, {}, 0, 0, 0);
+            }
+            RecvMsgResult result = recvmsgv(fd, nonblocking_flags, iov, iovcnt);
+            if(result){
+                stats.blocking_wakeups++;
+                return result;
+            }else if(!result.would_block() && result != EINTR){//spurious readiness (e.g. another reader won) loops back into poll
+                return result;
+            }
+        }
+    }
+
+    template<typename... Args>
+    inline RecvMsgResult recvmsg_spin_then_block(int fd, int flags, const SpinThenBlockPolicy &policy, SpinThenBlockStats &stats, Args&&... pods){
+        auto buffers = make_iovec_array(std::forward<Args>(pods)...);
+        return recvmsgv_spin_then_block(fd, flags, buffers.data(), buffers.size(), policy, stats);
+    }
+}
+
+#endif
@@ -0,0 +1,181 @@
+#ifndef MPSL_LINUX_DIRECT_IO
+#define MPSL_LINUX_DIRECT_IO
+
+#include <sys/uio.h>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <sys/mount.h>
+#include <cstdlib>
+#include <cstdint>
+
+#include <algorithm>
+
+#include "mpsl/posix.h"
+
+//O_DIRECT support: alignment discovery/validation and aligned buffers
+namespace mpsl{
+
+    struct DirectIOAlignment{
+        size_t memory_alignment;//required alignment of buffer addresses
+        size_t offset_alignment;//required alignment of file offsets and transfer lengths
+    };
+
+    struct DirectIOAlignmentResult : public BaseResult{
+        DirectIOAlignment alignment;
+        inline DirectIOAlignment operator*(void) const{
+            return alignment;
+        }
+        inline DirectIOAlignmentResult():BaseResult(), alignment({0, 0}){}
+        inline DirectIOAlignmentResult(bool success, int errnum, DirectIOAlignment alignment): BaseResult(success, errnum), alignment(alignment){}
+    };
+
+    //uses statx(STATX_DIOALIGN) when the kernel reports it, otherwise the logical sector size for block devices
+    //and st_blksize for regular files (conservative, but always valid)
+    inline DirectIOAlignmentResult direct_io_alignment(int fd){
+#ifdef STATX_DIOALIGN
+        struct statx stx = {};
+        if(::statx(fd, "", AT_EMPTY_PATH, STATX_DIOALIGN, &stx) == 0 && (stx.stx_mask & STATX_DIOALIGN) && stx.stx_dio_mem_align != 0){
+            return DirectIOAlignmentResult(true, 0, {stx.stx_dio_mem_align, stx.stx_dio_offset_align});
+        }
+#endif
+        struct stat st;
+        if(::fstat(fd, &st) != 0){
+            return DirectIOAlignmentResult(false, errno, {0, 0});
+        }
+        if(S_ISBLK(st.st_mode)){
+            int sector_size = 0;
+            if(::ioctl(fd, BLKSSZGET, &sector_size) != 0){
+                return DirectIOAlignmentResult(false, errno, {0, 0});
+            }
+            return DirectIOAlignmentResult(true, 0, {(size_t) sector_size, (size_t) sector_size});
+        }
+        return DirectIOAlignmentResult(true, 0, {(size_t) st.st_blksize, (size_t) st.st_blksize});
+    }
+
+    inline size_t align_up(size_t value, size_t alignment){
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    inline bool is_direct_io_aligned(const DirectIOAlignment &alignment, const void *buf, size_t count, off_t offset){
+        return ((uintptr_t) buf % alignment.memory_alignment) == 0 &&
+            (count % alignment.offset_alignment) == 0 &&
+            ((size_t) offset % alignment.offset_alignment) == 0;
+    }
+
+    inline bool is_direct_io_aligned(const DirectIOAlignment &alignment, const struct iovec *iov, size_t iovcnt, off_t offset){
+        if(((size_t) offset % alignment.offset_alignment) != 0){
+            return false;
+        }
+        for(size_t i = 0; i < iovcnt; ++i){
+            if(((uintptr_t) iov[i].iov_base % alignment.memory_alignment) != 0 || (iov[i].iov_len % alignment.offset_alignment) != 0){
+                return false;
+            }
+        }
+        return true;
+    }
+
+    //EINVAL mirrors what the kernel would report for a misaligned O_DIRECT transfer, without issuing it
+    inline BaseResult validate_direct_io(const DirectIOAlignment &alignment, const struct iovec *iov, size_t iovcnt, off_t offset){
+        const bool aligned = is_direct_io_aligned(alignment, iov, iovcnt, offset);
+        return BaseResult(aligned, aligned ? 0 : EINVAL);
+    }
+
+    struct AlignedAllocResult : public BaseResult{
+        void *ptr;
+        size_t size;
+        inline void *operator*(void) const{
+            return ptr;
+        }
+        inline struct iovec iov() const{
+            return make_iovec(ptr, size);
+        }
+        inline AlignedAllocResult():BaseResult(), ptr(nullptr), size(0){}
+        inline AlignedAllocResult(bool success, int errnum, void *ptr, size_t size): BaseResult(success, errnum), ptr(ptr), size(size){}
+    };
+
+    //size is rounded up to alignment so the whole buffer can be handed to an O_DIRECT transfer, release with free_aligned
+    inline AlignedAllocResult alloc_aligned(size_t size, size_t alignment){
+        void *ptr = nullptr;
+        const size_t aligned_size = align_up(size, alignment);
+        const int ret = ::posix_memalign(&ptr, alignment, aligned_size);
+        return AlignedAllocResult(ret == 0, ret, ret == 0 ? ptr : nullptr, ret == 0 ? aligned_size : 0);
+    }
+
+    //the address needs memory_alignment but the length has to be a whole number of offset_alignment blocks
+    inline AlignedAllocResult alloc_aligned(size_t size, const DirectIOAlignment &alignment){
+        return alloc_aligned(size, std::max(alignment.memory_alignment, alignment.offset_alignment));
+    }
+
+    inline void free_aligned(void *ptr){
+        ::free(ptr);
+    }
+}
+
+#ifdef RWF_NOWAIT
+//preadv2/pwritev2 - flags are passed through: RWF_HIPRI, RWF_DSYNC, RWF_SYNC, RWF_NOWAIT, RWF_APPEND
+namespace mpsl{
+
+    inline IOVecWriteResult write_all_inplace_at(int fd, struct iovec *iov, const size_t iovcnt, off_t offset, int flags){
+        iovec_inplace_iterator iov_it(iov, iovcnt);
+        int lerrno = 0;
+        size_t running_total = 0;
+
+        for(;!iov_it.eov();){
+            assert(iov_it.iov_remaining() <= iovcnt);
+            assert(iov_it.head() >= iov && iov_it.head() <= iov_it.end());
+            ssize_t written = ::pwritev2(fd, iov_it.head(), iov_it.iov_remaining(), offset + (off_t) running_total, flags);
+            if(written == -1){
+                lerrno = errno;
+                if(lerrno == EINTR){
+                    continue;
+                }
+                break;
+            }else if(written == 0){
+                lerrno = ENOSPC;
+                break;
+            }
+            running_total += written;
+            iov_it.advance((size_t) written);
+        }
+        const bool success = iov_it.eov();
+        return IOVecWriteResult(success, lerrno, running_total, iov_it);
+    }
+
+    //with RWF_NOWAIT a read that would have to wait on the device stops with would_block(), nread/iterator hold the
+    //progress made from the page cache and the remainder can be offloaded to a thread that reads without the flag
+    inline IOVecReadResult read_all_inplace_at(int fd, struct iovec *iov, const size_t iovcnt, off_t offset, int flags){
+        iovec_inplace_iterator iov_it(iov, iovcnt);
+
+        int lerrno = 0;
+        bool eof = false;
+        size_t running_total = 0;
+        for(;!iov_it.eov();){
+            assert(iov_it.iov_remaining() <= iovcnt);
+            assert(iov_it.head() >= iov && iov_it.head() <= iov_it.end());
+            ssize_t nread = ::preadv2(fd, iov_it.head(), iov_it.iov_remaining(), offset + (off_t) running_total, flags);
+            if(nread == -1){
+                lerrno = errno;
+                if(lerrno == EINTR){
+                    continue;
+                }
+                break;
+            }else if(nread == 0 && iov_it.any_bytes_remaining()){
+                eof = true;
+                break;
+            }
+            running_total += nread;
+            iov_it.advance((size_t) nread);
+        }
+        const bool success = iov_it.eov();
+        return IOVecReadResult(success, eof, lerrno, running_total, iov_it);
+    }
+
+    //page cache only fast path - on would_block() continue at offset + nread with a blocking read elsewhere
+    inline ReadResult read_all_at_nowait(int fd, void *buf, size_t count, off_t offset){
+        struct iovec iov = make_iovec(buf, count);
+        return read_all_inplace_at(fd, &iov, 1, offset, RWF_NOWAIT);
+    }
+}
+#endif
+
+#endif
@@ -1,10 +1,18 @@
 #ifndef MPSL_LINUX_EVENTFD
 #define MPSL_LINUX_EVENTFD
 
+#include <sys/eventfd.h>
+
 #include "mpsl/posix.h"
 
 namespace mpsl{
 
+    struct ReadEventFDResult : public ReadResult{
+        uint64_t count;
+        inline ReadEventFDResult():ReadResult(), count(0){}
+        inline ReadEventFDResult(bool success, bool eof, int errnum, size_t nread, uint64_t count): ReadResult(success, eof, errnum, nread), count(count){}
+    };
+
     inline ReadEventFDResult read_eventfd(int fd){
         ReadEventFDResult result;
         static_cast<ReadResult&>(result) = read(fd, result.count);
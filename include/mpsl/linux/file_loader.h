@@ -0,0 +1,295 @@
+#ifndef MPSL_LINUX_FILE_LOADER
+#define MPSL_LINUX_FILE_LOADER
+
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "mpsl/posix.h"
+
+//parallel, positional loading/copying of large files
+namespace mpsl{
+
+    struct ParallelIOOptions{
+        size_t chunk_size;//bytes per range handed to a thread
+        size_t nthreads;
+        size_t window;//chunk buffers in flight for reads, bounds memory to window * chunk_size
+        size_t readahead_chunks;//how many chunks past the one being read get a POSIX_FADV_WILLNEED hint
+        inline ParallelIOOptions(): chunk_size(size_t(8) << 20), nthreads(4), window(8), readahead_chunks(4){}
+    };
+
+    struct ParallelReadResult : public ReadResult{
+        size_t nchunks;//chunks delivered to the callback
+        inline ParallelReadResult():ReadResult(), nchunks(0){}
+        inline ParallelReadResult(bool success, bool eof, int errnum, size_t nread, size_t nchunks): ReadResult(success, eof, errnum, nread), nchunks(nchunks){}
+    };
+
+    struct FileSizeResult : public BaseResult{
+        size_t size;
+        inline size_t operator*(void) const{
+            return size;
+        }
+        inline FileSizeResult():BaseResult(), size(0){}
+        inline FileSizeResult(bool success, int errnum, size_t size): BaseResult(success, errnum), size(size){}
+    };
+
+    inline FileSizeResult file_size(int fd){
+        struct stat st;
+        if(::fstat(fd, &st) != 0){
+            return FileSizeResult(false, errno, 0);
+        }
+        return FileSizeResult(true, 0, (size_t) st.st_size);
+    }
+
+    //reads [offset, offset + count) as chunk_size ranges on nthreads threads with pread, chunks are handed to
+    //on_chunk(off_t chunk_offset, const struct iovec &chunk) -> bool on the calling thread in file order.
+    //the chunk memory is reused once on_chunk returns; returning false stops the load early and fails the result, even on the last chunk.
+    //short files are delivered up to end of file and reported with eof().
+    //this pays off for uncached files on devices with queue depth to spare and several cores; for page cache hits a
+    //single read_all loop into one reused buffer is faster (fewer threads, the buffer stays in cache)
+    template<typename Callback>
+    inline ParallelReadResult read_file_parallel(int fd, off_t offset, size_t count, const ParallelIOOptions &options, Callback &&on_chunk){
+        struct Slot{
+            size_t nread;
+            int errnum;
+            bool eof;
+            bool done;
+        };
+        const size_t chunk_size = std::max(options.chunk_size, size_t(1));
+        const size_t nchunks = (count + chunk_size - 1) / chunk_size;
+        if(nchunks == 0){
+            return ParallelReadResult(true, false, 0, 0, 0);
+        }
+        const size_t window = std::min(std::max(options.window, size_t(1)), nchunks);
+        const size_t nthreads = std::min(std::max(options.nthreads, size_t(1)), window);
+        auto chunk_length = [&](size_t chunk) -> size_t{
+            return std::min(chunk_size, count - chunk * chunk_size);
+        };
+        auto advise = [&](size_t chunk){
+            if(chunk < nchunks){
+                ::posix_fadvise(fd, offset + (off_t) (chunk * chunk_size), (off_t) chunk_length(chunk), POSIX_FADV_WILLNEED);
+            }
+        };
+
+        std::unique_ptr<char[]> buffers(new char[window * chunk_size]);
+        std::vector<Slot> slots(window, Slot{0, 0, false, false});
+        std::mutex mutex;
+        std::condition_variable cv;
+        size_t next_claim = 0;
+        size_t next_deliver = 0;
+        bool stop = false;
+
+        ::posix_fadvise(fd, offset, (off_t) count, POSIX_FADV_SEQUENTIAL);
+        for(size_t chunk = 0; chunk < std::min(options.readahead_chunks, nchunks); ++chunk){
+            advise(chunk);
+        }
+
+        auto worker = [&]{
+            std::unique_lock<std::mutex> lock(mutex);
+            for(;;){
+                cv.wait(lock, [&]{ return stop || next_claim >= nchunks || next_claim < next_deliver + window; });
+                if(stop || next_claim >= nchunks){
+                    return;
+                }
+                const size_t chunk = next_claim++;
+                lock.unlock();
+
+                advise(chunk + options.readahead_chunks);
+                char *buf = buffers.get() + (chunk % window) * chunk_size;
+                ReadResult result = read_all_at(fd, buf, chunk_length(chunk), offset + (off_t) (chunk * chunk_size));
+
+                lock.lock();
+                slots[chunk % window] = Slot{result.nread, result.code().value(), result.eof(), true};
+                cv.notify_all();
+            }
+        };
+        //stops and joins the workers on every exit, so a throwing on_chunk (or thread creation) unwinds instead of
+        //destroying joinable threads, which would call std::terminate
+        struct JoinGuard{
+            std::vector<std::thread> &threads;
+            std::mutex &mutex;
+            std::condition_variable &cv;
+            bool &stop;
+            inline ~JoinGuard(){
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    stop = true;
+                }
+                cv.notify_all();
+                for(auto &thread : threads){
+                    if(thread.joinable()){
+                        thread.join();
+                    }
+                }
+            }
+        };
+        std::vector<std::thread> threads;
+        JoinGuard join_guard{threads, mutex, cv, stop};
+        threads.reserve(nthreads);
+        for(size_t i = 0; i < nthreads; ++i){
+            threads.emplace_back(worker);
+        }
+
+        int lerrno = 0;
+        bool eof = false;
+        size_t total = 0;
+        size_t delivered = 0;
+        bool stopped = false;//on_chunk asked to stop
+        for(; next_deliver < nchunks;){
+            const size_t chunk = next_deliver;
+            Slot slot;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [&]{ return slots[chunk % window].done; });
+                slot = slots[chunk % window];
+            }
+            const bool complete = slot.nread == chunk_length(chunk);
+            bool keep_going = complete;
+            if(slot.nread > 0){
+                struct iovec iov = make_iovec(buffers.get() + (chunk % window) * chunk_size, slot.nread);
+                if(!on_chunk(offset + (off_t) (chunk * chunk_size), iov)){
+                    stopped = true;
+                    keep_going = false;
+                }
+                total += slot.nread;
+                delivered++;
+            }
+            if(!complete){
+                lerrno = slot.errnum;
+                eof = slot.eof;
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                slots[chunk % window].done = false;
+                next_deliver++;
+                stop = !keep_going;
+            }
+            cv.notify_all();
+            if(!keep_going){
+                break;
+            }
+        }
+        return ParallelReadResult(total == count && !stopped, eof, lerrno, total, delivered);
+    }
+
+    template<typename Callback>
+    inline ParallelReadResult read_file_parallel(int fd, const ParallelIOOptions &options, Callback &&on_chunk){
+        FileSizeResult size = file_size(fd);
+        if(!size){
+            return ParallelReadResult(false, false, size.code().value(), 0, 0);
+        }
+        return read_file_parallel(fd, 0, *size, options, std::forward<Callback>(on_chunk));
+    }
+
+    //copy_file_range with explicit offsets on both sides, falls back to pread/pwrite through a bounce buffer when the
+    //kernel or filesystem pair cannot do it in kernel (EXDEV, ENOSYS, EOPNOTSUPP, EINVAL)
+    inline WriteResult copy_range_all(int fd_in, off_t offset_in, int fd_out, off_t offset_out, size_t count){
+        int lerrno = 0;
+        size_t total = 0;
+        while(total < count){
+            loff_t in = offset_in + (off_t) total;
+            loff_t out = offset_out + (off_t) total;
+            ssize_t copied = ::copy_file_range(fd_in, &in, fd_out, &out, count - total, 0);
+            if(copied == -1){
+                lerrno = errno;
+                if(lerrno == EINTR){
+                    continue;
+                }
+                break;
+            }else if(copied == 0){//source ended early
+                break;
+            }
+            total += copied;
+        }
+        if(total < count && (lerrno == EXDEV || lerrno == ENOSYS || lerrno == EOPNOTSUPP || lerrno == EINVAL)){
+            lerrno = 0;
+            const size_t buffer_size = std::min(count - total, size_t(1) << 20);
+            std::unique_ptr<char[]> buffer(new char[buffer_size]);
+            while(total < count){
+                const size_t length = std::min(buffer_size, count - total);
+                ReadResult rresult = read_some_at(fd_in, buffer.get(), length, 1, offset_in + (off_t) total);
+                if(!rresult){
+                    lerrno = rresult.code().value();
+                    break;
+                }
+                WriteResult wresult = write_all_at(fd_out, buffer.get(), rresult.nread, offset_out + (off_t) total);
+                total += wresult.nwritten;
+                if(!wresult){
+                    lerrno = wresult.code().value();
+                    break;
+                }
+            }
+        }
+        return WriteResult(total == count, lerrno, total);
+    }
+
+    //splits [offset_in, offset_in + count) into chunks copied concurrently, completion order is unspecified
+    inline WriteResult copy_file_parallel(int fd_in, off_t offset_in, int fd_out, off_t offset_out, size_t count, const ParallelIOOptions &options){
+        const size_t chunk_size = std::max(options.chunk_size, size_t(1));
+        const size_t nchunks = (count + chunk_size - 1) / chunk_size;
+        const size_t nthreads = std::min(std::max(options.nthreads, size_t(1)), std::max(nchunks, size_t(1)));
+        std::atomic<size_t> next_claim(0);
+        std::atomic<size_t> total(0);
+        std::atomic<int> first_error(0);
+
+        ::posix_fadvise(fd_in, offset_in, (off_t) count, POSIX_FADV_SEQUENTIAL);
+        auto worker = [&]{
+            for(;;){
+                const size_t chunk = next_claim.fetch_add(1);
+                if(chunk >= nchunks || first_error.load() != 0){
+                    return;
+                }
+                const size_t ahead = chunk + options.readahead_chunks;
+                if(ahead < nchunks){
+                    ::posix_fadvise(fd_in, offset_in + (off_t) (ahead * chunk_size), (off_t) std::min(chunk_size, count - ahead * chunk_size), POSIX_FADV_WILLNEED);
+                }
+                const size_t length = std::min(chunk_size, count - chunk * chunk_size);
+                WriteResult result = copy_range_all(fd_in, offset_in + (off_t) (chunk * chunk_size), fd_out, offset_out + (off_t) (chunk * chunk_size), length);
+                total += result.nwritten;
+                if(!result){
+                    int expected = 0;
+                    first_error.compare_exchange_strong(expected, result.code().value() ? result.code().value() : EIO);
+                    return;
+                }
+            }
+        };
+        //joins whatever was started even if creating a later thread throws
+        struct JoinGuard{
+            std::vector<std::thread> &threads;
+            inline ~JoinGuard(){
+                for(auto &thread : threads){
+                    if(thread.joinable()){
+                        thread.join();
+                    }
+                }
+            }
+        };
+        std::vector<std::thread> threads;
+        {
+            JoinGuard join_guard{threads};
+            threads.reserve(nthreads);
+            for(size_t i = 0; i < nthreads; ++i){
+                threads.emplace_back(worker);
+            }
+        }
+        return WriteResult(total.load() == count, first_error.load(), total.load());
+    }
+
+    inline WriteResult copy_file_parallel(int fd_in, int fd_out, const ParallelIOOptions &options){
+        FileSizeResult size = file_size(fd_in);
+        if(!size){
+            return WriteResult(false, size.code().value(), 0);
+        }
+        return copy_file_parallel(fd_in, 0, fd_out, 0, *size, options);
+    }
+}
+
+#endif
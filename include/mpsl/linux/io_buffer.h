@@ -0,0 +1,149 @@
+#ifndef MPSL_LINUX_IO_BUFFER
+#define MPSL_LINUX_IO_BUFFER
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "mpsl/posix.h"
+#include "mpsl/socket.h"
+
+//large I/O buffers backed by hugepages and placed on a NUMA node, usable directly with make_iovec
+namespace mpsl{
+
+    struct IOBufferOptions{
+        bool hugetlb;//try MAP_HUGETLB from the reserved pool first
+        bool transparent_hugepages;//MADV_HUGEPAGE on normal page mappings (including the hugetlb fallback)
+        bool populate;//fault every page in up front, after the NUMA policy is applied
+        bool lock;//mlock the buffer, which also populates it
+        int numa_node;//-1 leaves placement to the default policy
+        size_t hugepage_size;//MAP_HUGETLB page size (power of two, e.g. 2MB or 1GB), requested explicitly from the kernel
+        inline IOBufferOptions(): hugetlb(true), transparent_hugepages(true), populate(false), lock(false), numa_node(-1), hugepage_size(size_t(2) << 20){}
+    };
+
+    struct IOBufferResult : public BaseResult{
+        void *ptr;
+        size_t size;//mapped length, >= the requested size
+        bool hugetlb;//backed by MAP_HUGETLB pages
+        bool transparent_hugepages;//MADV_HUGEPAGE was accepted
+        bool numa_bound;//mbind to the requested node succeeded
+        bool locked;
+        inline void *operator*(void) const{
+            return ptr;
+        }
+        inline struct iovec iov() const{
+            return make_iovec(ptr, size);
+        }
+        inline IOBufferResult():BaseResult(), ptr(nullptr), size(0), hugetlb(false), transparent_hugepages(false), numa_bound(false), locked(false){}
+        inline IOBufferResult(bool success, int errnum, void *ptr, size_t size): BaseResult(success, errnum), ptr(ptr), size(size), hugetlb(false), transparent_hugepages(false), numa_bound(false), locked(false){}
+    };
+
+    //hugepages, placement and locking are best effort: success only reflects the mapping itself, the flags above
+    //report what was actually obtained so callers can log a fallback to normal pages
+    inline IOBufferResult alloc_io_buffer(size_t size, const IOBufferOptions &options = IOBufferOptions()){
+        const size_t page_size = (size_t) ::sysconf(_SC_PAGESIZE);
+        void *ptr = MAP_FAILED;
+        size_t mapped = 0;
+        bool hugetlb = false;
+        if(options.hugetlb && options.hugepage_size > 0 && (options.hugepage_size & (options.hugepage_size - 1)) == 0){
+            //the size is encoded in the flags so the mapping really uses hugepage_size pages rather than the system
+            //default, otherwise mapped (and the later munmap length) would not be a multiple of the page size used
+            mapped = (size + options.hugepage_size - 1) / options.hugepage_size * options.hugepage_size;
+            const int huge_flags = MAP_HUGETLB | (__builtin_ctzll((unsigned long long) options.hugepage_size) << MAP_HUGE_SHIFT);
+            ptr = ::mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | huge_flags, -1, 0);
+            hugetlb = ptr != MAP_FAILED;
+        }
+        if(ptr == MAP_FAILED){
+            mapped = (size + page_size - 1) / page_size * page_size;
+            ptr = ::mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if(ptr == MAP_FAILED){
+                return IOBufferResult(false, errno, nullptr, 0);
+            }
+        }
+        IOBufferResult result(true, 0, ptr, mapped);
+        result.hugetlb = hugetlb;
+        if(!hugetlb && options.transparent_hugepages){
+            result.transparent_hugepages = ::madvise(ptr, mapped, MADV_HUGEPAGE) == 0;
+        }
+        //policy has to be in place before first touch, otherwise pages land wherever the faulting thread runs
+        if(options.numa_node >= 0){
+            const size_t nbits = sizeof(unsigned long) * 8;
+            unsigned long nodemask[(1024 + nbits - 1) / nbits] = {};
+            if((size_t) options.numa_node < 1024){
+                nodemask[options.numa_node / nbits] = 1UL << (options.numa_node % nbits);
+                result.numa_bound = ::syscall(SYS_mbind, ptr, mapped, MPOL_BIND, nodemask, (unsigned long) 1024 + 1, 0) == 0;
+            }
+            if(!result.numa_bound){
+                result.error_code = std::error_code(errno, std::generic_category());
+            }
+        }
+        if(options.lock){
+            result.locked = ::mlock(ptr, mapped) == 0;
+            if(!result.locked){
+                result.error_code = std::error_code(errno, std::generic_category());
+            }
+        }
+        if(options.populate && !result.locked){
+            bool populated = false;
+#ifdef MADV_POPULATE_WRITE
+            populated = ::madvise(ptr, mapped, MADV_POPULATE_WRITE) == 0;
+#endif
+            if(!populated){
+                const size_t stride = hugetlb ? options.hugepage_size : page_size;
+                volatile char *bytes = (volatile char *) ptr;
+                for(size_t i = 0; i < mapped; i += stride){
+                    bytes[i] = 0;
+                }
+            }
+        }
+        return result;
+    }
+
+    inline BaseResult free_io_buffer(void *ptr, size_t size){
+        if(ptr == nullptr){
+            return BaseResult(true, 0);
+        }
+        const int result = ::munmap(ptr, size);
+        return BaseResult(result == 0, result == 0 ? 0 : errno);
+    }
+
+    inline BaseResult free_io_buffer(const IOBufferResult &buffer){
+        return free_io_buffer(buffer.ptr, buffer.size);
+    }
+
+    //node of the cpu the calling thread is running on, -1 if unknown
+    inline int current_numa_node(){
+        unsigned cpu = 0, node = 0;
+        if(::syscall(SYS_getcpu, &cpu, &node, nullptr) != 0){
+            return -1;
+        }
+        return (int) node;
+    }
+
+    inline int cpu_numa_node(int cpu){
+        for(int node = 0; node < 1024; ++node){
+            const std::string path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/node" + std::to_string(node);
+            if(::access(path.c_str(), F_OK) == 0){
+                return node;
+            }
+        }
+        return -1;
+    }
+
+    //node of the cpu that last processed packets for this socket (SO_INCOMING_CPU), -1 if unknown
+    inline int socket_numa_node(int sockfd){
+#ifdef SO_INCOMING_CPU
+        GetSockOptResult<int> cpu = getsockopt<int>(sockfd, SOL_SOCKET, SO_INCOMING_CPU);
+        if(cpu && *cpu >= 0){
+            return cpu_numa_node(*cpu);
+        }
+#endif
+        (void) sockfd;
+        return -1;
+    }
+}
+
+#endif
@@ -0,0 +1,249 @@
+#ifndef MPSL_LINUX_MAPPED_FILE
+#define MPSL_LINUX_MAPPED_FILE
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <utility>
+
+#include "mpsl/posix.h"
+
+//memory mapped file views, usable anywhere a buffer is (make_iovec, write_all, sendmsgv) without copying the file
+namespace mpsl{
+
+    struct MapOptions{
+        bool populate;//MAP_POPULATE: fault the whole range in up front
+        int advice;//MADV_NORMAL, MADV_SEQUENTIAL or MADV_RANDOM for the whole range
+        bool willneed;//MADV_WILLNEED: start readahead of the whole range asynchronously
+        bool hugepages;//MADV_HUGEPAGE, only honoured for shmem/tmpfs or with file backed THP enabled
+        bool private_mapping;//MAP_PRIVATE instead of MAP_SHARED, writes stay in this process
+        inline MapOptions(): populate(false), advice(MADV_NORMAL), willneed(false), hugepages(false), private_mapping(false){}
+    };
+
+    //owns the mapping (and the fd when opened from a path), move only. data()/size() describe the requested range,
+    //which may start inside the first page of the underlying page aligned mapping
+    class MappedFile{
+    public:
+        inline MappedFile(): m_base(nullptr), m_base_length(0), m_delta(0), m_offset(0), m_length(0), m_fd(-1), m_owns_fd(false), m_prot(0), m_flags(0){}
+        inline MappedFile(void *base, size_t base_length, size_t delta, off_t offset, size_t length, int fd, bool owns_fd, int prot, int flags):
+            m_base(base), m_base_length(base_length), m_delta(delta), m_offset(offset), m_length(length), m_fd(fd), m_owns_fd(owns_fd), m_prot(prot), m_flags(flags){}
+        inline MappedFile(MappedFile &&other): MappedFile(){
+            swap(other);
+        }
+        inline MappedFile &operator=(MappedFile &&other){
+            if(this != &other){
+                reset();
+                swap(other);
+            }
+            return *this;
+        }
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+        inline ~MappedFile(){
+            reset();
+        }
+
+        inline char *data() const{
+            return m_base ? (char *) m_base + m_delta : nullptr;
+        }
+        inline size_t size() const{
+            return m_length;
+        }
+        inline bool empty() const{
+            return m_length == 0;
+        }
+        inline off_t offset() const{//file offset of data()
+            return m_offset;
+        }
+        inline int fd() const{
+            return m_fd;
+        }
+        inline struct iovec iov() const{
+            return make_iovec(data(), m_length);
+        }
+        inline struct iovec iov(size_t offset, size_t length) const{
+            return make_iovec(data() + offset, length);
+        }
+
+        //unmaps (and closes an owned fd), the view becomes empty
+        inline BaseResult reset(){
+            int lerrno = 0;
+            if(m_base != nullptr && ::munmap(m_base, m_base_length) != 0){
+                lerrno = errno;
+            }
+            if(m_owns_fd){
+                CloseResult closed = close(m_fd);
+                if(!closed && lerrno == 0){
+                    lerrno = closed.code().value();
+                }
+            }
+            m_base = nullptr;
+            m_base_length = m_delta = m_length = 0;
+            m_offset = 0;
+            m_fd = -1;
+            m_owns_fd = false;
+            return BaseResult(lerrno == 0, lerrno);
+        }
+
+        //advice for [offset, offset + length) of the view, length 0 means to the end
+        inline BaseResult advise(int advice, size_t offset = 0, size_t length = 0) const{
+            if(m_base == nullptr){
+                return BaseResult(true, 0);
+            }
+            if(length == 0 || offset + length > m_length){
+                length = m_length > offset ? m_length - offset : 0;
+            }
+            const size_t page_size = (size_t) ::sysconf(_SC_PAGESIZE);
+            const size_t begin = (m_delta + offset) / page_size * page_size;
+            const size_t end = m_delta + offset + length;
+            const int ret = ::madvise((char *) m_base + begin, end - begin, advice);
+            return BaseResult(ret == 0, ret == 0 ? 0 : errno);
+        }
+
+        //asynchronous readahead of a range about to be touched
+        inline BaseResult prefetch(size_t offset, size_t length) const{
+            return advise(MADV_WILLNEED, offset, length);
+        }
+
+        //MS_SYNC or MS_ASYNC for writable shared views
+        inline BaseResult sync(int flags = MS_SYNC) const{
+            if(m_base == nullptr){
+                return BaseResult(true, 0);
+            }
+            const int ret = ::msync(m_base, m_base_length, flags);
+            return BaseResult(ret == 0, ret == 0 ? 0 : errno);
+        }
+
+        //extends (or shrinks) the view to new_length bytes from offset(), for files being appended to.
+        //new_length 0 follows the current file size. data() may move, previously taken iovecs become invalid
+        inline BaseResult remap(size_t new_length = 0){
+            if(new_length == 0){
+                struct stat st;
+                if(::fstat(m_fd, &st) != 0){
+                    return BaseResult(false, errno);
+                }
+                new_length = (size_t) st.st_size > (size_t) m_offset ? (size_t) st.st_size - (size_t) m_offset : 0;
+            }
+            if(new_length == m_length){
+                return BaseResult(true, 0);
+            }
+            const size_t new_base_length = m_delta + new_length;
+            void *base;
+            if(m_base == nullptr){
+                base = ::mmap(nullptr, new_base_length, m_prot, m_flags, m_fd, m_offset - (off_t) m_delta);
+            }else if(new_length == 0){
+                if(::munmap(m_base, m_base_length) != 0){
+                    return BaseResult(false, errno);
+                }
+                m_base = nullptr;
+                m_base_length = m_length = 0;
+                return BaseResult(true, 0);
+            }else{
+                base = ::mremap(m_base, m_base_length, new_base_length, MREMAP_MAYMOVE);
+            }
+            if(base == MAP_FAILED){
+                return BaseResult(false, errno);
+            }
+            m_base = base;
+            m_base_length = new_base_length;
+            m_length = new_length;
+            return BaseResult(true, 0);
+        }
+
+        inline void swap(MappedFile &other){
+            std::swap(m_base, other.m_base);
+            std::swap(m_base_length, other.m_base_length);
+            std::swap(m_delta, other.m_delta);
+            std::swap(m_offset, other.m_offset);
+            std::swap(m_length, other.m_length);
+            std::swap(m_fd, other.m_fd);
+            std::swap(m_owns_fd, other.m_owns_fd);
+            std::swap(m_prot, other.m_prot);
+            std::swap(m_flags, other.m_flags);
+        }
+
+    private:
+        void *m_base;//page aligned start of the mapping
+        size_t m_base_length;
+        size_t m_delta;//data() - m_base
+        off_t m_offset;
+        size_t m_length;
+        int m_fd;
+        bool m_owns_fd;
+        int m_prot;
+        int m_flags;
+    };
+
+    struct MapResult : public BaseResult{
+        MappedFile map;
+        inline const MappedFile &operator*(void) const{
+            return map;
+        }
+        inline MappedFile *operator->(void){
+            return &map;
+        }
+        inline MapResult(): BaseResult(), map(){}
+        inline MapResult(bool success, int errnum): BaseResult(success, errnum), map(){}
+        inline MapResult(MappedFile &&map): BaseResult(true, 0), map(std::move(map)){}
+    };
+
+    //maps [offset, offset + length) of fd, offset need not be page aligned. prot is PROT_READ and/or PROT_WRITE.
+    //a zero length maps nothing but still yields a view that remap() can grow
+    inline MapResult map_file(int fd, off_t offset, size_t length, int prot, const MapOptions &options = MapOptions(), bool owns_fd = false){
+        const size_t page_size = (size_t) ::sysconf(_SC_PAGESIZE);
+        const size_t delta = (size_t) offset % page_size;
+        const int flags = (options.private_mapping ? MAP_PRIVATE : MAP_SHARED) | (options.populate ? MAP_POPULATE : 0);
+        if(length == 0){
+            return MapResult(MappedFile(nullptr, 0, delta, offset, 0, fd, owns_fd, prot, flags & ~MAP_POPULATE));
+        }
+        void *base = ::mmap(nullptr, delta + length, prot, flags, fd, offset - (off_t) delta);
+        if(base == MAP_FAILED){
+            const int lerrno = errno;
+            if(owns_fd){
+                close(fd);
+            }
+            return MapResult(false, lerrno);
+        }
+        //later remaps should not fault the whole file in again
+        MappedFile map(base, delta + length, delta, offset, length, fd, owns_fd, prot, flags & ~MAP_POPULATE);
+        if(options.advice != MADV_NORMAL){
+            map.advise(options.advice);
+        }
+        if(options.hugepages){
+            map.advise(MADV_HUGEPAGE);
+        }
+        if(options.willneed){
+            map.advise(MADV_WILLNEED);
+        }
+        return MapResult(std::move(map));
+    }
+
+    //maps the whole current file
+    inline MapResult map_file(int fd, int prot = PROT_READ, const MapOptions &options = MapOptions(), bool owns_fd = false){
+        struct stat st;
+        if(::fstat(fd, &st) != 0){
+            const int lerrno = errno;
+            if(owns_fd){
+                close(fd);
+            }
+            return MapResult(false, lerrno);
+        }
+        return map_file(fd, 0, (size_t) st.st_size, prot, options, owns_fd);
+    }
+
+    //opens path (read only unless writable) and maps all of it, the view owns the fd so it can be remapped later
+    inline MapResult map_file(const char *path, bool writable = false, const MapOptions &options = MapOptions()){
+        OpenResult opened = open(path, (writable ? O_RDWR : O_RDONLY) | O_CLOEXEC);
+        if(!opened){
+            return MapResult(false, opened.code().value());
+        }
+        return map_file(*opened, writable ? PROT_READ | PROT_WRITE : PROT_READ, options, true);
+    }
+
+    inline MapResult map_file(const std::string &path, bool writable = false, const MapOptions &options = MapOptions()){
+        return map_file(path.c_str(), writable, options);
+    }
+}
+
+#endif
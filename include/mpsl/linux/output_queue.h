@@ -0,0 +1,162 @@
+#ifndef MPSL_LINUX_OUTPUT_QUEUE
+#define MPSL_LINUX_OUTPUT_QUEUE
+
+#include <netinet/tcp.h>
+#include <limits.h>
+
+#include <cstdint>
+#include <vector>
+#include <tuple>
+#include <algorithm>
+
+#include "mpsl/socket.h"
+#include "mpsl/time.h"
+
+//per connection output batching: many logical writes become few sendmsg calls and full sized segments
+namespace mpsl{
+
+    enum class OutputCoalescing{
+        none,
+        msg_more,//threshold flushes pass MSG_MORE, explicit and deadline flushes push what the kernel held back
+        tcp_cork//TCP_CORK is held while data is queued or unpushed and released by explicit and deadline flushes
+    };
+
+    struct OutputQueuePolicy{
+        size_t flush_bytes;//queued bytes that trigger a flush
+        size_t flush_segments;//queued iovecs that trigger a flush
+        uint64_t flush_delay_nanos;//max time the oldest queued byte waits, see output_queue_deadline
+        OutputCoalescing coalescing;
+        inline OutputQueuePolicy(): flush_bytes(64 * 1024), flush_segments(64), flush_delay_nanos(50000), coalescing(OutputCoalescing::msg_more){}
+    };
+
+    //queued iovecs reference caller memory, which has to stay valid until it has been flushed
+    struct OutputQueue{
+        int fd;
+        OutputQueuePolicy policy;
+        std::vector<struct iovec> iov;
+        size_t head;//first iovec not completely written
+        size_t queued_bytes;
+        uint64_t oldest_nanos;//CLOCK_MONOTONIC time the oldest queued or unpushed byte was appended
+        bool corked;
+        bool unpushed;//bytes were sent with MSG_MORE or under the cork, the kernel may still hold a partial segment
+        inline OutputQueue(): fd(-1), policy(), head(0), queued_bytes(0), oldest_nanos(0), corked(false), unpushed(false){}
+        inline OutputQueue(int fd, const OutputQueuePolicy &policy): fd(fd), policy(policy), head(0), queued_bytes(0), oldest_nanos(0), corked(false), unpushed(false){
+            iov.reserve(policy.flush_segments);
+        }
+    };
+
+    struct OutputFlushResult : public WriteResult{
+        size_t pending;//bytes still queued, non zero together with would_block() means the socket is full
+        inline OutputFlushResult():WriteResult(), pending(0){}
+        inline OutputFlushResult(bool success, int errnum, size_t nwritten, size_t pending): WriteResult(success, errnum, nwritten), pending(pending){}
+    };
+
+    inline size_t output_queue_pending(const OutputQueue &queue){
+        return queue.queued_bytes;
+    }
+
+    inline bool output_queue_empty(const OutputQueue &queue){
+        return queue.queued_bytes == 0;
+    }
+
+    //CLOCK_MONOTONIC nanos by which the queue should be flushed, 0 when nothing is queued or held back by the
+    //kernel - suitable for arming a timerfd. a threshold flush that drains the queue still leaves a deadline
+    inline uint64_t output_queue_deadline(const OutputQueue &queue){
+        return queue.queued_bytes || queue.unpushed ? queue.oldest_nanos + queue.policy.flush_delay_nanos : 0;
+    }
+
+    inline SetSockOptResult output_queue_set_cork(OutputQueue &queue, bool cork){
+        if(queue.corked == cork){
+            return SetSockOptResult(true, 0);
+        }
+        SetSockOptResult result = setsockopt(queue.fd, IPPROTO_TCP, TCP_CORK, int(cork));
+        if(result){
+            queue.corked = cork;
+        }
+        return result;
+    }
+
+    //writes as much as the socket takes without blocking, push = false keeps the kernel coalescing (MSG_MORE / cork held).
+    //push = true also releases bytes held back by earlier MSG_MORE sends or the cork once the queue is drained
+    inline OutputFlushResult output_queue_flush(OutputQueue &queue, bool push = true){
+        const int more = !push && queue.policy.coalescing == OutputCoalescing::msg_more ? MSG_MORE : 0;
+        int lerrno = 0;
+        size_t total = 0;
+        while(queue.head < queue.iov.size()){
+            const size_t iovcnt = std::min(queue.iov.size() - queue.head, (size_t) IOV_MAX);
+            SendMsgResult result = sendmsgv(queue.fd, nullptr, 0, queue.iov.data() + queue.head, iovcnt, MSG_DONTWAIT | MSG_NOSIGNAL | more, nullptr, 0);
+            if(!result && (result.written == 0 || result.written == (size_t) -1)){
+                lerrno = result.code().value();
+                if(lerrno == EINTR){
+                    lerrno = 0;
+                    continue;
+                }
+                break;
+            }
+            total += result.written;
+            queue.queued_bytes -= result.written;
+            queue.unpushed = more != 0 || queue.corked;//a send without MSG_MORE pushes everything pending
+            struct iovec *it;
+            size_t remainder;
+            std::tie(it, remainder, std::ignore) = iovec_advance(queue.iov.data() + queue.head, iovcnt, result.written);
+            queue.head = it - queue.iov.data();
+            if(remainder > 0){
+                it->iov_base = (char *) it->iov_base + (it->iov_len - remainder);
+                it->iov_len = remainder;
+            }
+        }
+        if(queue.head == queue.iov.size()){
+            queue.iov.clear();
+            queue.head = 0;
+        }else if(queue.head > queue.iov.size() / 2){
+            queue.iov.erase(queue.iov.begin(), queue.iov.begin() + queue.head);
+            queue.head = 0;
+        }
+        if(queue.queued_bytes == 0 && push && (queue.corked || queue.unpushed)){
+            //clearing TCP_CORK pushes pending frames, which also flushes a tail held back by MSG_MORE
+            SetSockOptResult uncorked = queue.corked ? output_queue_set_cork(queue, false) : setsockopt(queue.fd, IPPROTO_TCP, TCP_CORK, 0);
+            if(uncorked || (!queue.corked && (uncorked.code().value() == EOPNOTSUPP || uncorked.code().value() == ENOPROTOOPT))){
+                queue.unpushed = false;//not TCP: MSG_MORE held nothing back
+            }else if(lerrno == 0){
+                lerrno = uncorked.code().value();
+            }
+        }
+        return OutputFlushResult(queue.queued_bytes == 0 && lerrno == 0, lerrno, total, queue.queued_bytes);
+    }
+
+    //flushes when the deadline has passed, call from the timer/loop tick with the current CLOCK_MONOTONIC nanos
+    inline OutputFlushResult output_queue_flush_expired(OutputQueue &queue, uint64_t now_nanos){
+        if((queue.queued_bytes == 0 && !queue.unpushed) || now_nanos < output_queue_deadline(queue)){
+            return OutputFlushResult(true, 0, 0, queue.queued_bytes);
+        }
+        return output_queue_flush(queue, true);
+    }
+
+    inline OutputFlushResult output_queue_appendv(OutputQueue &queue, const struct iovec *iov, size_t iovcnt){
+        if(queue.queued_bytes == 0 && !queue.unpushed){
+            queue.oldest_nanos = clock_gettime(CLOCK_MONOTONIC).nanos();
+            if(queue.policy.coalescing == OutputCoalescing::tcp_cork){
+                output_queue_set_cork(queue, true);
+            }
+        }
+        for(size_t i = 0; i < iovcnt; ++i){
+            if(iov[i].iov_len){
+                queue.iov.push_back(iov[i]);
+                queue.queued_bytes += iov[i].iov_len;
+            }
+        }
+        if(queue.queued_bytes >= queue.policy.flush_bytes || queue.iov.size() - queue.head >= queue.policy.flush_segments){
+            return output_queue_flush(queue, false);
+        }
+        return OutputFlushResult(true, 0, 0, queue.queued_bytes);
+    }
+
+    //queues one logical write (e.g. header, body), flushing when a byte or segment threshold is crossed
+    template<typename... Args>
+    inline OutputFlushResult output_queue_write(OutputQueue &queue, Args&&... pods){
+        auto buffers = make_iovec_array(std::forward<Args>(pods)...);
+        return output_queue_appendv(queue, buffers.data(), buffers.size());
+    }
+}
+
+#endif
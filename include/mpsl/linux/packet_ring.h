@@ -0,0 +1,225 @@
+#ifndef MPSL_LINUX_PACKET_RING
+#define MPSL_LINUX_PACKET_RING
+
+#include <sys/mman.h>
+#include <poll.h>
+#include <net/if.h>
+#include <net/ethernet.h>
+#include <linux/if_packet.h>
+
+#include <cstdint>
+
+#include "mpsl/socket.h"
+
+//AF_PACKET receive through a TPACKET_V3 mmap ring: frames are walked in user space, syscalls only happen when the ring is empty
+namespace mpsl{
+
+    struct PacketRingOptions{
+        int protocol;//ethertype in host order, ETH_P_ALL captures everything
+        int ifindex;//0 binds to all interfaces, see if_nametoindex
+        unsigned block_size;//must be a multiple of the page size
+        unsigned block_count;
+        unsigned frame_size;//upper bound hint for the kernel, V3 packs variable length frames inside a block
+        unsigned retire_timeout_millis;//a partially filled block is handed to user space after this long
+        int fanout_group;//-1 disables PACKET_FANOUT, otherwise sockets sharing the id split traffic
+        int fanout_mode;//PACKET_FANOUT_HASH, PACKET_FANOUT_LB, PACKET_FANOUT_CPU, ... optionally | PACKET_FANOUT_FLAG_*
+        inline PacketRingOptions(): protocol(ETH_P_ALL), ifindex(0), block_size(1u << 22), block_count(64), frame_size(2048), retire_timeout_millis(60), fanout_group(-1), fanout_mode(PACKET_FANOUT_HASH){}
+    };
+
+    struct PacketRing{
+        int fd;
+        char *map;
+        size_t map_size;
+        unsigned block_size;
+        unsigned block_count;
+        unsigned block;//block currently being walked
+        uint32_t frames_left;//frames not yet handed out from the current block, 0 when it is not owned by user space
+        struct tpacket3_hdr *frame;//next frame within the current block
+        inline PacketRing(): fd(-1), map(nullptr), map_size(0), block_size(0), block_count(0), block(0), frames_left(0), frame(nullptr){}
+    };
+
+    struct PacketRingResult : public BaseResult{
+        PacketRing ring;
+        inline const PacketRing &operator*(void) const{
+            return ring;
+        }
+        inline PacketRingResult():BaseResult(), ring(){}
+        inline PacketRingResult(bool success, int errnum, const PacketRing &ring): BaseResult(success, errnum), ring(ring){}
+    };
+
+    struct PacketFrame{
+        struct iovec data;//captured bytes starting at the link layer header, valid until its block is released
+        const struct tpacket3_hdr *header;//timestamps, original length (tp_len), vlan and rxhash
+        inline PacketFrame(): data({nullptr, 0}), header(nullptr){}
+        inline size_t wire_length() const{
+            return header ? header->tp_len : 0;
+        }
+        inline bool truncated() const{
+            return header && header->tp_snaplen < header->tp_len;
+        }
+    };
+
+    inline BaseResult packet_ring_close(PacketRing &ring){
+        int lerrno = 0;
+        if(ring.map != nullptr && ::munmap(ring.map, ring.map_size) != 0){
+            lerrno = errno;
+        }
+        CloseResult closed = close(ring.fd);
+        if(lerrno == 0 && !closed){
+            lerrno = closed.code().value();
+        }
+        ring = PacketRing();
+        return BaseResult(lerrno == 0, lerrno);
+    }
+
+    inline PacketRingResult packet_ring_open(const PacketRingOptions &options){
+        PacketRing ring;
+        auto fail = [&ring](int lerrno){
+            packet_ring_close(ring);
+            return PacketRingResult(false, lerrno, PacketRing());
+        };
+
+        SocketResult sock = mpsl::socket(AF_PACKET, SOCK_RAW, htons(options.protocol));
+        if(!sock){
+            return PacketRingResult(false, sock.code().value(), ring);
+        }
+        ring.fd = *sock;
+
+        SetSockOptResult result = setsockopt(ring.fd, SOL_PACKET, PACKET_VERSION, int(TPACKET_V3));
+        if(!result){
+            return fail(result.code().value());
+        }
+
+        struct tpacket_req3 req = {};
+        req.tp_block_size = options.block_size;
+        req.tp_block_nr = options.block_count;
+        req.tp_frame_size = options.frame_size;
+        req.tp_frame_nr = (options.block_size / options.frame_size) * options.block_count;
+        req.tp_retire_blk_tov = options.retire_timeout_millis;
+        req.tp_feature_req_word = TP_FT_REQ_FILL_RXHASH;
+        result = setsockopt(ring.fd, SOL_PACKET, PACKET_RX_RING, req);
+        if(!result){
+            return fail(result.code().value());
+        }
+
+        ring.map_size = (size_t) options.block_size * options.block_count;
+        void *map = ::mmap(nullptr, ring.map_size, PROT_READ | PROT_WRITE, MAP_SHARED, ring.fd, 0);
+        if(map == MAP_FAILED){
+            const int lerrno = errno;
+            ring.map_size = 0;
+            return fail(lerrno);
+        }
+        ring.map = (char *) map;
+        ring.block_size = options.block_size;
+        ring.block_count = options.block_count;
+
+        struct sockaddr_ll address = {};
+        address.sll_family = AF_PACKET;
+        address.sll_protocol = htons(options.protocol);
+        address.sll_ifindex = options.ifindex;
+        BindResult bound = mpsl::bind(ring.fd, address);
+        if(!bound){
+            return fail(bound.code().value());
+        }
+
+        if(options.fanout_group >= 0){
+            const int fanout = (options.fanout_group & 0xffff) | (options.fanout_mode << 16);
+            result = setsockopt(ring.fd, SOL_PACKET, PACKET_FANOUT, fanout);
+            if(!result){
+                return fail(result.code().value());
+            }
+        }
+        return PacketRingResult(true, 0, ring);
+    }
+
+    inline struct tpacket_block_desc *packet_ring_block(const PacketRing &ring, unsigned block){
+        return (struct tpacket_block_desc *) (ring.map + (size_t) block * ring.block_size);
+    }
+
+    //hands the current block back to the kernel, frames from it must no longer be used
+    inline void packet_ring_release_block(PacketRing &ring){
+        struct tpacket_block_desc *desc = packet_ring_block(ring, ring.block);
+        __atomic_store_n(&desc->hdr.bh1.block_status, (uint32_t) TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+        ring.block = (ring.block + 1) % ring.block_count;
+        ring.frames_left = 0;
+        ring.frame = nullptr;
+    }
+
+    //non-blocking, false when the ring is empty. moving past the last frame of a block releases that block,
+    //so a frame stays valid until the call after the one returning the final frame of its block
+    inline bool packet_ring_next(PacketRing &ring, PacketFrame &frame){
+        if(ring.frames_left == 0){
+            if(ring.frame != nullptr){
+                packet_ring_release_block(ring);
+            }
+            for(;;){
+                struct tpacket_block_desc *desc = packet_ring_block(ring, ring.block);
+                const uint32_t status = __atomic_load_n(&desc->hdr.bh1.block_status, __ATOMIC_ACQUIRE);
+                if(!(status & TP_STATUS_USER)){
+                    return false;
+                }
+                if(desc->hdr.bh1.num_pkts == 0){//retired empty, nothing to hand out
+                    __atomic_store_n(&desc->hdr.bh1.block_status, (uint32_t) TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+                    ring.block = (ring.block + 1) % ring.block_count;
+                    continue;
+                }
+                ring.frames_left = desc->hdr.bh1.num_pkts;
+                ring.frame = (struct tpacket3_hdr *) ((char *) desc + desc->hdr.bh1.offset_to_first_pkt);
+                break;
+            }
+        }
+        struct tpacket3_hdr *hdr = ring.frame;
+        frame.header = hdr;
+        frame.data = make_iovec((char *) hdr + hdr->tp_mac, hdr->tp_snaplen);
+        ring.frames_left--;
+        ring.frame = (struct tpacket3_hdr *) ((char *) hdr + hdr->tp_next_offset);
+        return true;
+    }
+
+    //blocks in poll only when the ring is empty; a timeout comes back as would_block()
+    inline BaseResult packet_ring_wait(PacketRing &ring, PacketFrame &frame, int timeout_millis){
+        for(;;){
+            if(packet_ring_next(ring, frame)){
+                return BaseResult(true, 0);
+            }
+            struct pollfd pfd = {ring.fd, POLLIN | POLLERR, 0};
+            const int ready = ::poll(&pfd, 1, timeout_millis);
+            if(ready == -1){
+                const int lerrno = errno;
+                if(lerrno == EINTR){
+                    continue;
+                }
+                return BaseResult(false, lerrno);
+            }else if(ready == 0){
+                return BaseResult(false, EAGAIN);
+            }
+        }
+    }
+
+    //hands every frame currently in the ring to on_frame(const PacketFrame &) and returns how many there were
+    template<typename Callback>
+    inline size_t packet_ring_drain(PacketRing &ring, Callback &&on_frame){
+        size_t count = 0;
+        PacketFrame frame;
+        while(packet_ring_next(ring, frame)){
+            on_frame(frame);
+            count++;
+        }
+        return count;
+    }
+
+    struct PacketStatsResult : public BaseResult{
+        struct tpacket_stats_v3 stats;//reading resets the kernel counters
+        inline const struct tpacket_stats_v3 &operator*(void) const{
+            return stats;
+        }
+        inline PacketStatsResult(bool success, int errnum, const struct tpacket_stats_v3 &stats): BaseResult(success, errnum), stats(stats){}
+    };
+
+    inline PacketStatsResult packet_ring_stats(const PacketRing &ring){
+        GetSockOptResult<struct tpacket_stats_v3> result = getsockopt<struct tpacket_stats_v3>(ring.fd, SOL_PACKET, PACKET_STATISTICS);
+        return PacketStatsResult(result.success, result.code().value(), result.value);
+    }
+}
+
+#endif
@@ -0,0 +1,323 @@
+#ifndef MPSL_LINUX_SHM_RING
+#define MPSL_LINUX_SHM_RING
+
+#include <sys/mman.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+
+#include <cstdint>
+#include <cstring>
+
+#include "mpsl/socket.h"
+#include "mpsl/linux/eventfd.h"
+
+//single producer / single consumer ring of variable length records in a memfd shared by two processes.
+//eventfds are only written when the other side announced it is about to sleep, so a busy pair makes no syscalls
+namespace mpsl{
+
+    struct ShmRingHeader{
+        uint64_t magic;
+        uint64_t capacity;//bytes of record space following the header page, power of two
+        alignas(64) uint64_t head;//written by the producer: end of the last published record
+        alignas(64) uint64_t consumer_waiting;//set by the consumer before it sleeps on data_eventfd
+        alignas(64) uint64_t tail;//written by the consumer: start of the first unconsumed record
+        alignas(64) uint64_t producer_waiting;//set by the producer before it sleeps on space_eventfd
+    };
+
+    //records are an 8 byte header followed by the payload, padded to 8 bytes; a padding record skips to the wrap point
+    struct ShmRingRecordHeader{
+        uint32_t length;
+        uint32_t padding;
+    };
+
+    static const uint64_t shm_ring_magic = 0x6d70736c72696e67ULL;//"mpslring"
+
+    //each process holds its own ShmRing, the cached positions are local to that side
+    struct ShmRing{
+        int memfd;
+        int data_eventfd;//consumer sleeps on it
+        int space_eventfd;//producer sleeps on it
+        ShmRingHeader *header;
+        char *data;
+        size_t map_size;
+        uint64_t capacity;
+        uint64_t head;//producer: next write position
+        uint64_t tail;//consumer: next read position
+        uint64_t cached_head;//consumer: last head observed
+        uint64_t cached_tail;//producer: last tail observed
+        inline ShmRing(): memfd(-1), data_eventfd(-1), space_eventfd(-1), header(nullptr), data(nullptr), map_size(0), capacity(0), head(0), tail(0), cached_head(0), cached_tail(0){}
+    };
+
+    struct ShmRingResult : public BaseResult{
+        ShmRing ring;
+        inline const ShmRing &operator*(void) const{
+            return ring;
+        }
+        inline ShmRingResult():BaseResult(), ring(){}
+        inline ShmRingResult(bool success, int errnum, const ShmRing &ring): BaseResult(success, errnum), ring(ring){}
+    };
+
+    inline size_t shm_ring_header_size(){
+        const size_t page_size = (size_t) ::sysconf(_SC_PAGESIZE);
+        return (sizeof(ShmRingHeader) + page_size - 1) / page_size * page_size;
+    }
+
+    inline uint64_t shm_ring_record_size(size_t length){
+        return (sizeof(ShmRingRecordHeader) + length + 7) & ~uint64_t(7);
+    }
+
+    //largest payload accepted by push, a record never takes more than half the ring so a wrap always fits
+    inline size_t shm_ring_max_record(const ShmRing &ring){
+        return ring.capacity / 2 - sizeof(ShmRingRecordHeader);
+    }
+
+    inline BaseResult shm_ring_close(ShmRing &ring){
+        int lerrno = 0;
+        if(ring.header != nullptr && ::munmap(ring.header, ring.map_size) != 0){
+            lerrno = errno;
+        }
+        const int fds[] = {ring.memfd, ring.data_eventfd, ring.space_eventfd};
+        for(int fd : fds){
+            CloseResult closed = close(fd);
+            if(lerrno == 0 && !closed){
+                lerrno = closed.code().value();
+            }
+        }
+        ring = ShmRing();
+        return BaseResult(lerrno == 0, lerrno);
+    }
+
+    inline BaseResult shm_ring_map(ShmRing &ring, bool initialize){
+        const size_t header_size = shm_ring_header_size();
+        void *map = ::mmap(nullptr, ring.map_size, PROT_READ | PROT_WRITE, MAP_SHARED, ring.memfd, 0);
+        if(map == MAP_FAILED){
+            return BaseResult(false, errno);
+        }
+        ring.header = (ShmRingHeader *) map;
+        ring.data = (char *) map + header_size;
+        if(initialize){
+            ring.header->capacity = ring.capacity;
+            __atomic_store_n(&ring.header->magic, shm_ring_magic, __ATOMIC_RELEASE);
+        }else if(__atomic_load_n(&ring.header->magic, __ATOMIC_ACQUIRE) != shm_ring_magic || ring.header->capacity != ring.capacity){
+            return BaseResult(false, EINVAL);
+        }
+        ring.head = ring.cached_head = __atomic_load_n(&ring.header->head, __ATOMIC_ACQUIRE);
+        ring.tail = ring.cached_tail = __atomic_load_n(&ring.header->tail, __ATOMIC_ACQUIRE);
+        return BaseResult(true, 0);
+    }
+
+    //capacity is rounded up to a power of two
+    inline ShmRingResult shm_ring_create(size_t capacity, const char *name = "mpsl-shm-ring"){
+        ShmRing ring;
+        ring.capacity = 64;
+        while(ring.capacity < capacity){
+            ring.capacity <<= 1;
+        }
+        ring.map_size = shm_ring_header_size() + ring.capacity;
+        auto fail = [&ring](int lerrno){
+            shm_ring_close(ring);
+            return ShmRingResult(false, lerrno, ShmRing());
+        };
+
+        ring.memfd = ::memfd_create(name, MFD_CLOEXEC);
+        if(ring.memfd == -1){
+            return fail(errno);
+        }
+        if(::ftruncate(ring.memfd, (off_t) ring.map_size) != 0){
+            return fail(errno);
+        }
+        ring.data_eventfd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        ring.space_eventfd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if(ring.data_eventfd == -1 || ring.space_eventfd == -1){
+            return fail(errno);
+        }
+        BaseResult mapped = shm_ring_map(ring, true);
+        if(!mapped){
+            return fail(mapped.code().value());
+        }
+        return ShmRingResult(true, 0, ring);
+    }
+
+    //hands the memfd and both eventfds to the peer over a unix socket in one SCM_RIGHTS message
+    inline SendMsgResult shm_ring_send(int sockfd, const ShmRing &ring){
+        const int fds[3] = {ring.memfd, ring.data_eventfd, ring.space_eventfd};
+        union{
+            char buf[CMSG_SPACE(sizeof(fds))];
+            struct cmsghdr align;
+        } control;
+        std::memset(&control, 0, sizeof(control));
+        struct cmsghdr *cmsg = (struct cmsghdr *) control.buf;
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+        std::memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+        const uint64_t capacity = ring.capacity;
+        return sendmsg_with_ancillary(sockfd, MSG_NOSIGNAL, control.buf, sizeof(control.buf), capacity);
+    }
+
+    inline ShmRingResult shm_ring_receive(int sockfd){
+        ShmRing ring;
+        int fds[3] = {-1, -1, -1};
+        union{
+            char buf[CMSG_SPACE(sizeof(fds))];
+            struct cmsghdr align;
+        } control;
+        std::memset(&control, 0, sizeof(control));
+        uint64_t capacity = 0;
+        RecvMsgResult received = recvmsg_with_ancillary(sockfd, MSG_CMSG_CLOEXEC, control.buf, sizeof(control.buf), capacity);
+        if(!received){
+            return ShmRingResult(false, received.code().value(), ring);
+        }
+        struct msghdr msg = {};
+        msg.msg_control = control.buf;
+        msg.msg_controllen = received.controllen;
+        for(struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)){
+            if(cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS && cmsg->cmsg_len == CMSG_LEN(sizeof(fds))){
+                std::memcpy(fds, CMSG_DATA(cmsg), sizeof(fds));
+            }
+        }
+        ring.memfd = fds[0];
+        ring.data_eventfd = fds[1];
+        ring.space_eventfd = fds[2];
+        ring.capacity = capacity;
+        ring.map_size = shm_ring_header_size() + ring.capacity;
+        if(!received.all() || fds[0] == -1 || fds[1] == -1 || fds[2] == -1 || capacity == 0 || (capacity & (capacity - 1)) != 0){
+            shm_ring_close(ring);
+            return ShmRingResult(false, EPROTO, ShmRing());
+        }
+        BaseResult mapped = shm_ring_map(ring, false);
+        if(!mapped){
+            const int lerrno = mapped.code().value();
+            shm_ring_close(ring);
+            return ShmRingResult(false, lerrno, ShmRing());
+        }
+        return ShmRingResult(true, 0, ring);
+    }
+
+    //the store of our own position and the load of the peer's waiting flag are ordered by a full fence on both sides
+    inline void shm_ring_wake(int eventfd, uint64_t *waiting){
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if(__atomic_load_n(waiting, __ATOMIC_RELAXED) && __atomic_exchange_n(waiting, uint64_t(0), __ATOMIC_ACQ_REL)){
+            notify_eventfd(eventfd);
+        }
+    }
+
+    //producer: copies the gathered payload in as one record. would_block() when the ring is full, EMSGSIZE when the
+    //record can never fit (see shm_ring_max_record)
+    inline BaseResult shm_ring_pushv(ShmRing &ring, const struct iovec *iov, size_t iovcnt){
+        const size_t length = iovec_nbytes(iov, (int) iovcnt);
+        if(length > shm_ring_max_record(ring)){
+            return BaseResult(false, EMSGSIZE);
+        }
+        const uint64_t mask = ring.capacity - 1;
+        const uint64_t record_size = shm_ring_record_size(length);
+        const uint64_t to_end = ring.capacity - (ring.head & mask);
+        const uint64_t needed = to_end < record_size ? to_end + record_size : record_size;
+        if(ring.head + needed - ring.cached_tail > ring.capacity){
+            ring.cached_tail = __atomic_load_n(&ring.header->tail, __ATOMIC_ACQUIRE);
+            if(ring.head + needed - ring.cached_tail > ring.capacity){
+                return BaseResult(false, EAGAIN);
+            }
+        }
+        if(to_end < record_size){
+            ShmRingRecordHeader *pad = (ShmRingRecordHeader *) (ring.data + (ring.head & mask));
+            pad->length = (uint32_t) (to_end - sizeof(ShmRingRecordHeader));
+            pad->padding = 1;
+            ring.head += to_end;
+        }
+        char *out = ring.data + (ring.head & mask);
+        ShmRingRecordHeader *record = (ShmRingRecordHeader *) out;
+        record->length = (uint32_t) length;
+        record->padding = 0;
+        out += sizeof(ShmRingRecordHeader);
+        for(size_t i = 0; i < iovcnt; ++i){
+            std::memcpy(out, iov[i].iov_base, iov[i].iov_len);
+            out += iov[i].iov_len;
+        }
+        ring.head += record_size;
+        __atomic_store_n(&ring.header->head, ring.head, __ATOMIC_RELEASE);
+        shm_ring_wake(ring.data_eventfd, &ring.header->consumer_waiting);
+        return BaseResult(true, 0);
+    }
+
+    template<typename... Args>
+    inline BaseResult shm_ring_push(ShmRing &ring, Args&&... pods){
+        auto buffers = make_iovec_array(std::forward<Args>(pods)...);
+        return shm_ring_pushv(ring, buffers.data(), buffers.size());
+    }
+
+    //consumer: the oldest record without consuming it, false when the ring is empty. the payload stays valid until shm_ring_pop
+    inline bool shm_ring_peek(ShmRing &ring, struct iovec &record){
+        const uint64_t mask = ring.capacity - 1;
+        for(;;){
+            if(ring.tail == ring.cached_head){
+                ring.cached_head = __atomic_load_n(&ring.header->head, __ATOMIC_ACQUIRE);
+                if(ring.tail == ring.cached_head){
+                    return false;
+                }
+            }
+            ShmRingRecordHeader *header = (ShmRingRecordHeader *) (ring.data + (ring.tail & mask));
+            if(header->padding){
+                ring.tail += ring.capacity - (ring.tail & mask);
+                continue;
+            }
+            record = make_iovec((char *) header + sizeof(ShmRingRecordHeader), header->length);
+            return true;
+        }
+    }
+
+    inline void shm_ring_pop(ShmRing &ring, const struct iovec &record){
+        ring.tail += shm_ring_record_size(record.iov_len);
+        __atomic_store_n(&ring.header->tail, ring.tail, __ATOMIC_RELEASE);
+        shm_ring_wake(ring.space_eventfd, &ring.header->producer_waiting);
+    }
+
+    //sleeps on eventfd after announcing itself in waiting and re-checking ready(), a timeout comes back as would_block().
+    //a stale notification can end the sleep early, callers re-check and wait again
+    template<typename Ready>
+    inline BaseResult shm_ring_sleep(int eventfd, uint64_t *waiting, int timeout_millis, Ready &&ready){
+        __atomic_store_n(waiting, uint64_t(1), __ATOMIC_SEQ_CST);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if(ready()){
+            __atomic_store_n(waiting, uint64_t(0), __ATOMIC_RELAXED);
+            return BaseResult(true, 0);
+        }
+        struct pollfd pfd = {eventfd, POLLIN, 0};
+        int ret;
+        do{
+            ret = ::poll(&pfd, 1, timeout_millis);
+        }while(ret == -1 && errno == EINTR);
+        const int lerrno = ret == -1 ? errno : 0;
+        __atomic_store_n(waiting, uint64_t(0), __ATOMIC_RELAXED);
+        if(ret > 0){
+            read_eventfd(eventfd);
+        }
+        return ret > 0 ? BaseResult(true, 0) : BaseResult(false, ret == 0 ? EAGAIN : lerrno);
+    }
+
+    //consumer: waits until a record is available
+    inline BaseResult shm_ring_wait_readable(ShmRing &ring, int timeout_millis){
+        struct iovec record;
+        if(shm_ring_peek(ring, record)){
+            return BaseResult(true, 0);
+        }
+        return shm_ring_sleep(ring.data_eventfd, &ring.header->consumer_waiting, timeout_millis, [&ring, &record]{ return shm_ring_peek(ring, record); });
+    }
+
+    //producer: waits until a record of length bytes would fit
+    inline BaseResult shm_ring_wait_writable(ShmRing &ring, size_t length, int timeout_millis){
+        const uint64_t record_size = shm_ring_record_size(length);
+        auto fits = [&ring, record_size]{
+            const uint64_t to_end = ring.capacity - (ring.head & (ring.capacity - 1));
+            const uint64_t needed = to_end < record_size ? to_end + record_size : record_size;
+            ring.cached_tail = __atomic_load_n(&ring.header->tail, __ATOMIC_ACQUIRE);
+            return ring.head + needed - ring.cached_tail <= ring.capacity;
+        };
+        if(fits()){
+            return BaseResult(true, 0);
+        }
+        return shm_ring_sleep(ring.space_eventfd, &ring.header->producer_waiting, timeout_millis, fits);
+    }
+}
+
+#endif
@@ -0,0 +1,278 @@
+#ifndef MPSL_LINUX_TCP_INFO_SAMPLER
+#define MPSL_LINUX_TCP_INFO_SAMPLER
+
+#include <sys/timerfd.h>
+#include <netinet/tcp.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "mpsl/socket.h"
+#include "mpsl/time.h"
+#include "mpsl/linux/timerfd.h"
+
+//periodic TCP_INFO sampling for many connections with a bounded number of getsockopt calls per tick
+namespace mpsl{
+
+    //leading part of the kernel's struct tcp_info (linux/tcp.h) through tcpi_delivery_rate. netinet/tcp.h stops at
+    //tcpi_total_retrans and linux/tcp.h cannot be included next to it, so the layout is mirrored here
+    struct TcpInfoKernel{
+        uint8_t tcpi_state;
+        uint8_t tcpi_ca_state;
+        uint8_t tcpi_retransmits;
+        uint8_t tcpi_probes;
+        uint8_t tcpi_backoff;
+        uint8_t tcpi_options;
+        uint8_t tcpi_snd_wscale : 4, tcpi_rcv_wscale : 4;
+        uint8_t tcpi_delivery_rate_app_limited : 1, tcpi_fastopen_client_fail : 2;
+        uint32_t tcpi_rto;
+        uint32_t tcpi_ato;
+        uint32_t tcpi_snd_mss;
+        uint32_t tcpi_rcv_mss;
+        uint32_t tcpi_unacked;
+        uint32_t tcpi_sacked;
+        uint32_t tcpi_lost;
+        uint32_t tcpi_retrans;
+        uint32_t tcpi_fackets;
+        uint32_t tcpi_last_data_sent;
+        uint32_t tcpi_last_ack_sent;
+        uint32_t tcpi_last_data_recv;
+        uint32_t tcpi_last_ack_recv;
+        uint32_t tcpi_pmtu;
+        uint32_t tcpi_rcv_ssthresh;
+        uint32_t tcpi_rtt;
+        uint32_t tcpi_rttvar;
+        uint32_t tcpi_snd_ssthresh;
+        uint32_t tcpi_snd_cwnd;
+        uint32_t tcpi_advmss;
+        uint32_t tcpi_reordering;
+        uint32_t tcpi_rcv_rtt;
+        uint32_t tcpi_rcv_space;
+        uint32_t tcpi_total_retrans;
+        uint64_t tcpi_pacing_rate;
+        uint64_t tcpi_max_pacing_rate;
+        uint64_t tcpi_bytes_acked;
+        uint64_t tcpi_bytes_received;
+        uint32_t tcpi_segs_out;
+        uint32_t tcpi_segs_in;
+        uint32_t tcpi_notsent_bytes;
+        uint32_t tcpi_min_rtt;
+        uint32_t tcpi_data_segs_in;
+        uint32_t tcpi_data_segs_out;
+        uint64_t tcpi_delivery_rate;
+    };
+
+    //older kernels return a shorter tcp_info: accepted as long as it covers every field before tcpi_delivery_rate,
+    //the missing tail reads as zero. EPROTO when the kernel returned less than that
+    inline GetSockOptResult<TcpInfoKernel> get_tcp_info(int sockfd){
+        TcpInfoKernel info = {};
+        socklen_t length = sizeof(info);
+        if(::getsockopt(sockfd, IPPROTO_TCP, TCP_INFO, &info, &length) != 0){
+            return GetSockOptResult<TcpInfoKernel>(false, errno, info);
+        }
+        const bool complete = length >= offsetof(TcpInfoKernel, tcpi_delivery_rate);
+        return GetSockOptResult<TcpInfoKernel>(complete, complete ? 0 : EPROTO, info);
+    }
+
+    //compact subset of struct tcp_info (linux/tcp.h), 40 bytes
+    struct TcpInfoSample{
+        uint64_t nanos;//CLOCK_MONOTONIC time of the sample
+        uint64_t delivery_rate;//bytes per second
+        uint32_t rtt_usecs;
+        uint32_t rttvar_usecs;
+        uint32_t snd_cwnd;//segments
+        uint32_t total_retrans;
+        uint32_t unacked;
+        uint8_t state;
+        uint8_t ca_state;
+        uint8_t retransmits;//consecutive unrecovered retransmits of the head segment
+        uint8_t app_limited;//delivery_rate was measured while the sender had nothing to send
+    };
+
+    inline TcpInfoSample make_tcp_info_sample(const TcpInfoKernel &info, uint64_t nanos){
+        TcpInfoSample sample = {};
+        sample.nanos = nanos;
+        sample.delivery_rate = info.tcpi_delivery_rate;
+        sample.rtt_usecs = info.tcpi_rtt;
+        sample.rttvar_usecs = info.tcpi_rttvar;
+        sample.snd_cwnd = info.tcpi_snd_cwnd;
+        sample.total_retrans = info.tcpi_total_retrans;
+        sample.unacked = info.tcpi_unacked;
+        sample.state = info.tcpi_state;
+        sample.ca_state = info.tcpi_ca_state;
+        sample.retransmits = info.tcpi_retransmits;
+        sample.app_limited = info.tcpi_delivery_rate_app_limited;
+        return sample;
+    }
+
+    static const size_t tcp_info_history = 16;
+
+    struct TcpInfoConnection{
+        int fd;
+        uint32_t count;//samples taken, the ring holds the last min(count, tcp_info_history)
+        uint32_t errors;//failed getsockopt calls
+        std::array<TcpInfoSample, tcp_info_history> ring;
+        inline TcpInfoConnection(): fd(-1), count(0), errors(0), ring(){}
+        inline explicit TcpInfoConnection(int fd): fd(fd), count(0), errors(0), ring(){}
+    };
+
+    struct TcpInfoSampler{
+        std::vector<TcpInfoConnection> connections;
+        std::unordered_map<int, size_t> index;//fd -> position in connections
+        size_t cursor;//next connection to sample, round robin
+        size_t budget;//max connections sampled per tick
+        int timerfd;
+        inline TcpInfoSampler(): cursor(0), budget(1024), timerfd(-1){}
+        inline explicit TcpInfoSampler(size_t budget): cursor(0), budget(budget), timerfd(-1){}
+    };
+
+    inline void tcp_info_sampler_add(TcpInfoSampler &sampler, int fd){
+        if(sampler.index.count(fd) == 0){
+            sampler.index[fd] = sampler.connections.size();
+            sampler.connections.emplace_back(fd);
+        }
+    }
+
+    //swap-removes, so the round robin order changes. connections below the cursor were already sampled this pass: when
+    //the last (not yet sampled) one would move into that range it is swapped back to just ahead of the cursor instead,
+    //so every remaining connection is still visited once per pass
+    inline void tcp_info_sampler_remove(TcpInfoSampler &sampler, int fd){
+        auto it = sampler.index.find(fd);
+        if(it == sampler.index.end()){
+            return;
+        }
+        const size_t position = it->second;
+        const size_t last = sampler.connections.size() - 1;
+        sampler.index.erase(it);
+        if(position != last){
+            sampler.connections[position] = std::move(sampler.connections[last]);
+            sampler.index[sampler.connections[position].fd] = position;
+            if(position < sampler.cursor && sampler.cursor <= last){
+                sampler.cursor--;
+                std::swap(sampler.connections[position], sampler.connections[sampler.cursor]);
+                sampler.index[sampler.connections[position].fd] = position;
+                sampler.index[sampler.connections[sampler.cursor].fd] = sampler.cursor;
+            }
+        }
+        sampler.connections.pop_back();
+        if(sampler.cursor >= sampler.connections.size()){
+            sampler.cursor = 0;
+        }
+    }
+
+    struct TcpInfoTickResult : public BaseResult{
+        size_t sampled;
+        size_t failed;
+        inline size_t operator*(void) const{
+            return sampled;
+        }
+        inline TcpInfoTickResult():BaseResult(), sampled(0), failed(0){}
+        inline TcpInfoTickResult(bool success, int errnum, size_t sampled, size_t failed): BaseResult(success, errnum), sampled(sampled), failed(failed){}
+    };
+
+    //samples up to budget connections round robin, a full pass over n connections takes ceil(n / budget) ticks
+    inline TcpInfoTickResult tcp_info_sampler_tick(TcpInfoSampler &sampler){
+        const size_t n = std::min(sampler.budget, sampler.connections.size());
+        const uint64_t now = clock_gettime(CLOCK_MONOTONIC).nanos();
+        size_t failed = 0;
+        int lerrno = 0;
+        for(size_t i = 0; i < n; ++i){
+            if(sampler.cursor >= sampler.connections.size()){
+                sampler.cursor = 0;
+            }
+            TcpInfoConnection &connection = sampler.connections[sampler.cursor++];
+            GetSockOptResult<TcpInfoKernel> info = get_tcp_info(connection.fd);
+            if(!info){
+                connection.errors++;
+                failed++;
+                lerrno = info.code().value();
+                continue;
+            }
+            connection.ring[connection.count % tcp_info_history] = make_tcp_info_sample(*info, now);
+            connection.count++;
+        }
+        return TcpInfoTickResult(failed == 0, lerrno, n - failed, failed);
+    }
+
+    //creates a CLOCK_MONOTONIC timerfd firing every period_nanos, add sampler.timerfd to the event loop
+    inline BaseResult tcp_info_sampler_start(TcpInfoSampler &sampler, uint64_t period_nanos){
+        if(sampler.timerfd == -1){
+            sampler.timerfd = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+            if(sampler.timerfd == -1){
+                return BaseResult(false, errno);
+            }
+        }
+        TimerFDSetTimeResult result = timerfd_settime(sampler.timerfd, 0, make_itimerspec_nanos(period_nanos, period_nanos));
+        return BaseResult(result.success, result.code().value());
+    }
+
+    inline CloseResult tcp_info_sampler_stop(TcpInfoSampler &sampler){
+        CloseResult result = close(sampler.timerfd);
+        sampler.timerfd = -1;
+        return result;
+    }
+
+    //call when timerfd is readable; missed expirations are not made up for so the per tick budget stays the bound
+    inline TcpInfoTickResult tcp_info_sampler_on_timer(TcpInfoSampler &sampler){
+        ReadTimerFDResult expired = read_timerfd(sampler.timerfd);
+        if(!expired){
+            return TcpInfoTickResult(false, expired.code().value(), 0, 0);
+        }
+        return tcp_info_sampler_tick(sampler);
+    }
+
+    struct TcpInfoSnapshot{
+        std::vector<TcpInfoSample> samples;//oldest first
+        uint32_t min_rtt_usecs;
+        uint32_t max_rtt_usecs;
+        uint32_t retrans_delta;//total_retrans growth across the retained samples
+        uint32_t min_cwnd;
+        uint64_t max_delivery_rate;
+        uint32_t errors;
+        inline TcpInfoSnapshot(): min_rtt_usecs(0), max_rtt_usecs(0), retrans_delta(0), min_cwnd(0), max_delivery_rate(0), errors(0){}
+    };
+
+    struct TcpInfoSnapshotResult : public BaseResult{
+        TcpInfoSnapshot snapshot;
+        inline const TcpInfoSnapshot &operator*(void) const{
+            return snapshot;
+        }
+        inline TcpInfoSnapshotResult(bool success, int errnum): BaseResult(success, errnum), snapshot(){}
+    };
+
+    //ENOENT when fd is not being sampled
+    inline TcpInfoSnapshotResult tcp_info_snapshot(const TcpInfoSampler &sampler, int fd){
+        auto it = sampler.index.find(fd);
+        if(it == sampler.index.end()){
+            return TcpInfoSnapshotResult(false, ENOENT);
+        }
+        const TcpInfoConnection &connection = sampler.connections[it->second];
+        TcpInfoSnapshotResult result(true, 0);
+        TcpInfoSnapshot &snapshot = result.snapshot;
+        snapshot.errors = connection.errors;
+        const uint32_t retained = std::min<uint32_t>(connection.count, tcp_info_history);
+        snapshot.samples.reserve(retained);
+        for(uint32_t i = connection.count - retained; i < connection.count; ++i){
+            snapshot.samples.push_back(connection.ring[i % tcp_info_history]);
+        }
+        if(retained == 0){
+            return result;
+        }
+        snapshot.min_rtt_usecs = snapshot.max_rtt_usecs = snapshot.samples.front().rtt_usecs;
+        snapshot.min_cwnd = snapshot.samples.front().snd_cwnd;
+        for(const TcpInfoSample &sample : snapshot.samples){
+            snapshot.min_rtt_usecs = std::min(snapshot.min_rtt_usecs, sample.rtt_usecs);
+            snapshot.max_rtt_usecs = std::max(snapshot.max_rtt_usecs, sample.rtt_usecs);
+            snapshot.min_cwnd = std::min(snapshot.min_cwnd, sample.snd_cwnd);
+            snapshot.max_delivery_rate = std::max(snapshot.max_delivery_rate, sample.delivery_rate);
+        }
+        snapshot.retrans_delta = snapshot.samples.back().total_retrans - snapshot.samples.front().total_retrans;
+        return result;
+    }
+}
+
+#endif
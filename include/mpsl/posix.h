@@ -157,6 +157,68 @@ namespace mpsl{
 
 }
 
+//positional operations - these do not use or move the file offset
+namespace mpsl{
+
+    inline WriteResult write_some_at(int fd, const void *_buf, size_t max_count, size_t min_count, off_t offset){
+        const char *buf = (const char *) _buf;
+        int lerrno = 0;
+        size_t total = 0;
+        while(total < min_count) {
+            ssize_t written = ::pwrite(fd, (const void *)buf, max_count - total, offset + (off_t) total);
+            if (written == -1){
+                lerrno = errno;
+                if(lerrno == EINTR){
+                    continue;
+                }
+                break;
+            }else if(written == 0){
+                lerrno = ENOSPC;
+                break;
+            }
+            buf += written;
+            total += written;
+        }
+        return WriteResult(total >= min_count, lerrno, total);
+    }
+
+    inline WriteResult write_all_at(int fd, const void *buf, size_t count, off_t offset){
+        return write_some_at(fd, buf, count, count, offset);
+    }
+
+    inline ReadResult read_some_at(int fd, void *_buf, size_t max_count, size_t min_count, off_t offset){
+        char *buf = (char *) _buf;
+        int lerrno = 0;
+        size_t total = 0;
+        bool eof = false;
+        while(total < max_count){
+            ssize_t nread = ::pread(fd, (void *) buf, max_count - total, offset + (off_t) total);
+            if(nread == -1){
+                lerrno = errno;
+                if(lerrno == EINTR){
+                    continue;
+                }
+                break;
+            }else if(nread == 0){
+                eof = true;
+                break;
+            }
+
+            buf += nread;
+            total += nread;
+            if(total >= min_count){
+                break;
+            }
+        }
+        return ReadResult(total >= min_count, eof, lerrno, total);
+    }
+
+    inline ReadResult read_all_at(int fd, void *buf, size_t count, off_t offset){
+        return read_some_at(fd, buf, count, count, offset);
+    }
+
+}
+
 //vector extensions
 namespace mpsl{
     struct IOVecWriteResult : public WriteResult{
@@ -208,6 +270,13 @@ namespace mpsl{
         return write_all_inplace(fd, buffers.data(), buffers.size());
     }
 
+    //a single buffer needs no iovec bookkeeping, plain write(2)
+    template<typename Arg>
+    inline WriteResult write(int fd, Arg&& pod){
+        const struct iovec iov = make_iovec(pod);
+        return write_all(fd, iov.iov_base, iov.iov_len);
+    }
+
     struct IOVecReadResult : public ReadResult{
         iovec_inplace_iterator iterator;//iterator to the current iovec sequence
         inline IOVecReadResult():ReadResult(), iterator(){}
@@ -258,6 +327,78 @@ namespace mpsl{
         auto buffers = make_iovec_array(std::forward<Args>(pods)...);
         return read_all_inplace(fd, buffers.data(), buffers.size());
     }
+
+    //a single buffer needs no iovec bookkeeping, plain read(2)
+    template<typename Arg>
+    inline ReadResult read(int fd, Arg&& pod){
+        const struct iovec iov = make_iovec(pod);
+        return read_all(fd, iov.iov_base, iov.iov_len);
+    }
+
+    //positional vector operations, offset is where the first byte of iov goes/comes from
+    inline IOVecWriteResult write_all_inplace_at(int fd, struct iovec *iov, const size_t iovcnt, off_t offset){
+        iovec_inplace_iterator iov_it(iov, iovcnt);
+        int lerrno = 0;
+        size_t running_total = 0;
+
+        for(;!iov_it.eov();){
+            assert(iov_it.iov_remaining() <= iovcnt);
+            assert(iov_it.head() >= iov && iov_it.head() <= iov_it.end());
+            ssize_t written = ::pwritev(fd, iov_it.head(), iov_it.iov_remaining(), offset + (off_t) running_total);
+            if(written == -1){
+                lerrno = errno;
+                if(lerrno == EINTR){
+                    continue;
+                }
+                break;
+            }else if(written == 0){
+                lerrno = ENOSPC;
+                break;
+            }
+            running_total += written;
+            iov_it.advance((size_t) written);
+        }
+        const bool success = iov_it.eov();
+        return IOVecWriteResult(success, lerrno, running_total, iov_it);
+    }
+
+    inline WriteResult write_all_at(int fd, const BufferSet &buffer, off_t offset){
+        std::vector<struct iovec> iov(buffer.iov, buffer.iov + buffer.count);
+        return write_all_inplace_at(fd, iov.data(), buffer.count, offset);
+    }
+
+    inline IOVecReadResult read_all_inplace_at(int fd, struct iovec *iov, const size_t iovcnt, off_t offset){
+        iovec_inplace_iterator iov_it(iov, iovcnt);
+
+        int lerrno = 0;
+        bool eof = false;
+        size_t running_total = 0;
+        for(;!iov_it.eov();){
+            assert(iov_it.iov_remaining() <= iovcnt);
+            assert(iov_it.head() >= iov && iov_it.head() <= iov_it.end());
+            ssize_t nread = ::preadv(fd, iov_it.head(), iov_it.iov_remaining(), offset + (off_t) running_total);
+            if(nread == -1){
+                lerrno = errno;
+                if(lerrno == EINTR){
+                    continue;
+                }
+                break;
+            }else if(nread == 0 && iov_it.any_bytes_remaining()){
+                eof = true;
+                break;
+            }
+            running_total += nread;
+            iov_it.advance((size_t) nread);
+        }
+        const bool success = iov_it.eov();
+        return IOVecReadResult(success, eof, lerrno, running_total, iov_it);
+    }
+
+    inline ReadResult read_all_at(int fd, BufferSet &buffer, off_t offset){
+        struct iovec *iov = (struct iovec *) alloca(buffer.count * sizeof(struct iovec));
+        std::copy(buffer.iov, buffer.iov + buffer.count, iov);
+        return read_all_inplace_at(fd, iov, buffer.count, offset);
+    }
 }
 
 #endif
@@ -0,0 +1,131 @@
+#ifndef MPSL_RESUMABLE_IO_H
+#define MPSL_RESUMABLE_IO_H
+
+#include <sys/socket.h>
+#include <limits.h>
+
+#include <algorithm>
+
+#include "mpsl/posix.h"
+
+//resumable vector reads/writes for non-blocking fds driven by (edge triggered) readiness events.
+//the operation keeps its own cursor into the caller's iovecs, which are consumed in place like the *_inplace calls,
+//so each resume continues where the last one stopped without copying or re-scanning the list
+namespace mpsl{
+
+    struct ResumableIO{
+        struct iovec *iov;//caller storage, modified in place
+        size_t iovcnt;
+        size_t head;//first iovec with bytes remaining
+        size_t total;//bytes the operation transfers when complete
+        size_t done;//bytes transferred so far
+        inline ResumableIO(): iov(nullptr), iovcnt(0), head(0), total(0), done(0){}
+        inline ResumableIO(struct iovec *iov, size_t iovcnt): iov(iov), iovcnt(iovcnt), head(0), total(iovec_nbytes(iov, (int) iovcnt)), done(0){
+            skip_empty();
+        }
+        inline bool complete() const{
+            return head == iovcnt;
+        }
+        inline size_t remaining() const{
+            return total - done;
+        }
+        //consumes nbytes from the cursor, touching only the iovecs they cover
+        inline void advance(size_t nbytes){
+            done += nbytes;
+            while(nbytes > 0){
+                struct iovec &v = iov[head];
+                if(nbytes < v.iov_len){
+                    v.iov_base = (char *) v.iov_base + nbytes;
+                    v.iov_len -= nbytes;
+                    break;
+                }
+                nbytes -= v.iov_len;
+                v.iov_len = 0;
+                head++;
+            }
+            skip_empty();
+        }
+        inline void skip_empty(){
+            while(head < iovcnt && iov[head].iov_len == 0){
+                head++;
+            }
+        }
+    };
+
+    typedef ResumableIO ResumableWrite;
+    typedef ResumableIO ResumableRead;
+
+    //success means the whole operation is complete. otherwise would_block() asks to resume on the next readiness
+    //event, eof() (reads) means the peer closed first, anything else is a hard error; nbytes is this call's progress
+    struct ResumeResult : public BaseResult{
+        size_t nbytes;
+        bool m_eof;
+        inline size_t operator*(void) const{
+            return nbytes;
+        }
+        inline bool eof() const{
+            return m_eof;
+        }
+        inline ResumeResult():BaseResult(), nbytes(0), m_eof(false){}
+        inline ResumeResult(bool success, bool eof, int errnum, size_t nbytes): BaseResult(success, errnum), nbytes(nbytes), m_eof(eof){}
+    };
+
+    //drives transfer(iov, iovcnt) -> ssize_t until the operation completes, the kernel reports EAGAIN or a read
+    //returns 0, so an edge triggered caller has always drained the readiness it was woken for.
+    //stop_on_short (opt in) returns would_block after a short transfer instead of confirming with another syscall.
+    //safe for writes; for reads the caller must register and handle EPOLLRDHUP, because data followed by a FIN yields
+    //a short read and without RDHUP no further edge arrives to read the 0 that follows
+    template<typename Transfer>
+    inline ResumeResult resume_transfer(ResumableIO &op, bool is_read, Transfer &&transfer, bool stop_on_short = false){
+        size_t progressed = 0;
+        while(!op.complete()){
+            const size_t iovcnt = std::min(op.iovcnt - op.head, (size_t) IOV_MAX);
+            const size_t requested = !stop_on_short ? 0 : iovcnt == op.iovcnt - op.head ? op.remaining() : iovec_nbytes(op.iov + op.head, (int) iovcnt);
+            const ssize_t n = transfer(op.iov + op.head, (int) iovcnt);
+            if(n == -1){
+                const int lerrno = errno;
+                if(lerrno == EINTR){
+                    continue;
+                }
+                return ResumeResult(false, false, lerrno, progressed);
+            }else if(n == 0){
+                return is_read ? ResumeResult(false, true, 0, progressed) : ResumeResult(false, false, ENOSPC, progressed);
+            }
+            op.advance((size_t) n);
+            progressed += (size_t) n;
+            if(stop_on_short && (size_t) n < requested){
+                return ResumeResult(op.complete(), false, op.complete() ? 0 : EAGAIN, progressed);
+            }
+        }
+        return ResumeResult(true, false, 0, progressed);
+    }
+
+    inline ResumeResult resume_write(int fd, ResumableWrite &op, bool stop_on_short = false){
+        return resume_transfer(op, false, [fd](struct iovec *iov, int iovcnt){ return ::writev(fd, iov, iovcnt); }, stop_on_short);
+    }
+
+    inline ResumeResult resume_read(int fd, ResumableRead &op, bool stop_on_short = false){
+        return resume_transfer(op, true, [fd](struct iovec *iov, int iovcnt){ return ::readv(fd, iov, iovcnt); }, stop_on_short);
+    }
+
+    //sockets: sendmsg so flags such as MSG_NOSIGNAL apply, MSG_DONTWAIT allows use on blocking sockets
+    inline ResumeResult resume_send(int fd, ResumableWrite &op, int flags = MSG_NOSIGNAL, bool stop_on_short = false){
+        return resume_transfer(op, false, [fd, flags](struct iovec *iov, int iovcnt){
+            struct msghdr msg_header = {};
+            msg_header.msg_iov = iov;
+            msg_header.msg_iovlen = iovcnt;
+            return ::sendmsg(fd, &msg_header, flags);
+        }, stop_on_short);
+    }
+
+    inline ResumeResult resume_recv(int fd, ResumableRead &op, int flags = 0, bool stop_on_short = false){
+        return resume_transfer(op, true, [fd, flags](struct iovec *iov, int iovcnt){
+            struct msghdr msg_header = {};
+            msg_header.msg_iov = iov;
+            msg_header.msg_iovlen = iovcnt;
+            return ::recvmsg(fd, &msg_header, flags);
+        }, stop_on_short);
+    }
+}
+
+#endif
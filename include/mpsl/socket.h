@@ -1,4 +1,8 @@
+#ifndef MPSL_SOCKET_H
+#define MPSL_SOCKET_H
+
 #include <sys/socket.h>
+#include <sys/un.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 
@@ -181,51 +185,44 @@ namespace mpsl{
         inline RecvMsgResult(bool success, int errnum, size_t input_size, size_t read, sockaddr_storage sockaddr, socklen_t sockaddr_len, int msg_flags, size_t controllen): BaseResult(success, errnum), sizeof_args(input_size), read(read), sockaddr(sockaddr), sockaddr_len(sockaddr_len), msg_flags(msg_flags), controllen(controllen){}
     };
 
-    inline RecvMsgResult recvmsgv(int fd, int flags, struct iovec *iov, const size_t iovcnt){
+    //nbytes is the total of iov, passed in so statically sized argument packs skip iovec_nbytes
+    inline RecvMsgResult recvmsgv(int fd, int flags, void *ancillary_data, size_t nancillary_bytes, struct iovec *iov, const size_t iovcnt, const size_t nbytes){
         sockaddr_storage _sockaddr;
         struct msghdr msg_header = {};
         msg_header.msg_name = &_sockaddr;
         msg_header.msg_namelen = sizeof(_sockaddr);
         msg_header.msg_iov = iov;
         msg_header.msg_iovlen = iovcnt;
-        msg_header.msg_control = NULL;
-        msg_header.msg_controllen = 0;
+        msg_header.msg_control = ancillary_data;
+        msg_header.msg_controllen = nancillary_bytes;
+
         int lerrno = 0;
         int nread = ::recvmsg(fd, &msg_header, flags);
         if (nread == -1){
             lerrno = errno;
         }
-        return RecvMsgResult(nread >= 0, lerrno, iovec_nbytes(iov, iovcnt), nread, _sockaddr, msg_header.msg_namelen, msg_header.msg_flags, msg_header.msg_controllen);
-    }
 
-    template<typename... Args>
-    inline RecvMsgResult recvmsg(int fd, int flags, Args&&... pods){
-        auto buffers = make_iovec_array(std::forward<Args>(pods)...);
-        return unistd::recvmsgv(fd, flags, buffers.data(), buffers.size());
+        return RecvMsgResult(nread >= 0, lerrno, nbytes, nread, _sockaddr, msg_header.msg_namelen, msg_header.msg_flags, msg_header.msg_controllen);
     }
 
     inline RecvMsgResult recvmsgv(int fd, int flags, void *ancillary_data, size_t nancillary_bytes, struct iovec *iov, const size_t iovcnt){
-        sockaddr_storage _sockaddr;
-        struct msghdr msg_header = {};
-        msg_header.msg_name = &_sockaddr;
-        msg_header.msg_namelen = sizeof(_sockaddr);
-        msg_header.msg_iov = iov;
-        msg_header.msg_iovlen = iovcnt;
-        msg_header.msg_control = ancillary_data;
-        msg_header.msg_controllen = nancillary_bytes;
+        return mpsl::recvmsgv(fd, flags, ancillary_data, nancillary_bytes, iov, iovcnt, iovec_nbytes(iov, iovcnt));
+    }
 
-        int lerrno = 0;
-        int nread = ::recvmsg(fd, &msg_header, flags);
-        if (nread == -1){
-            lerrno = errno;
-        }
+    inline RecvMsgResult recvmsgv(int fd, int flags, struct iovec *iov, const size_t iovcnt){
+        return mpsl::recvmsgv(fd, flags, NULL, 0, iov, iovcnt, iovec_nbytes(iov, iovcnt));
+    }
 
-        return RecvMsgResult(nread >= 0, lerrno, iovec_nbytes(iov, iovcnt), nread, _sockaddr, msg_header.msg_namelen, msg_header.msg_flags, msg_header.msg_controllen);
+    template<typename... Args>
+    inline RecvMsgResult recvmsg(int fd, int flags, Args&&... pods){
+        auto buffers = make_iovec_array(std::forward<Args>(pods)...);
+        return mpsl::recvmsgv(fd, flags, NULL, 0, buffers.data(), buffers.size(), iovec_array_nbytes<Args...>(buffers));
     }
+
     template<typename... Args>
     inline RecvMsgResult recvmsg_with_ancillary(int fd, int flags, void *ancillary_buffer, size_t ancillary_buffer_size, Args&&... pods){
         auto buffers = make_iovec_array(std::forward<Args>(pods)...);
-        return unistd::recvmsgv(fd, flags, ancillary_buffer, ancillary_buffer_size, buffers.data(), buffers.size());
+        return mpsl::recvmsgv(fd, flags, ancillary_buffer, ancillary_buffer_size, buffers.data(), buffers.size(), iovec_array_nbytes<Args...>(buffers));
     }
 
     struct SendToResult : public BaseResult{
@@ -256,8 +253,9 @@ namespace mpsl{
         inline SendMsgResult(bool success, int errnum, size_t written): BaseResult(success, errnum), written(written){}
     };
 
+    //nbytes is the total of iov, passed in so statically sized argument packs skip iovec_nbytes
     inline
-    SendMsgResult sendmsgv(int fd, const void *ancillary_data, size_t nancillary_bytes, const struct iovec *iov, const size_t iovcnt, int flags, const void *sockaddr, size_t sockaddr_len){
+    SendMsgResult sendmsgv(int fd, const void *ancillary_data, size_t nancillary_bytes, const struct iovec *iov, const size_t iovcnt, int flags, const void *sockaddr, size_t sockaddr_len, const size_t nbytes){
         int lerrno = 0;
         struct msghdr msg_header = {};
         msg_header.msg_name = (void *) sockaddr;
@@ -271,35 +269,64 @@ namespace mpsl{
         if (nwritten == -1){
             lerrno = errno;
         }
-        return SendMsgResult((size_t) nwritten == iovec_nbytes(iov, (int) iovcnt), lerrno, nwritten);
+        return SendMsgResult((size_t) nwritten == nbytes, lerrno, nwritten);
+    }
+
+    inline
+    SendMsgResult sendmsgv(int fd, const void *ancillary_data, size_t nancillary_bytes, const struct iovec *iov, const size_t iovcnt, int flags, const void *sockaddr, size_t sockaddr_len){
+        return mpsl::sendmsgv(fd, ancillary_data, nancillary_bytes, iov, iovcnt, flags, sockaddr, sockaddr_len, iovec_nbytes(iov, (int) iovcnt));
     }
 
     template<typename sockaddr_t>
     SendMsgResult sendmsgv(int fd, const struct iovec *iov, const size_t iovcnt, int flags, const sockaddr_t *sockaddr){
-        return unistd::sendmsgv(fd, nullptr, 0, iov, iovcnt, flags, sockaddr, sizeof(sockaddr_t));
+        return mpsl::sendmsgv(fd, nullptr, 0, iov, iovcnt, flags, sockaddr, sizeof(sockaddr_t));
     }
 
     template<typename sockaddr_t>
     SendMsgResult sendmsgv(int fd, const struct iovec *iov, const size_t iovcnt, int flags, const sockaddr_t &sockaddr){
-        return unistd::sendmsgv(fd, nullptr, 0, iov, iovcnt, flags, &sockaddr, sizeof(sockaddr_t));
+        return mpsl::sendmsgv(fd, nullptr, 0, iov, iovcnt, flags, &sockaddr, sizeof(sockaddr_t));
     }
 
     template<typename... Args>
     inline SendMsgResult sendmsg(int fd, int flags, Args&&... pods){
         auto buffers = make_iovec_array(std::forward<Args>(pods)...);
-        return unistd::sendmsgv(fd, nullptr, 0, buffers.data(), buffers.size(), flags, nullptr, 0);
+        return mpsl::sendmsgv(fd, nullptr, 0, buffers.data(), buffers.size(), flags, nullptr, 0, iovec_array_nbytes<Args...>(buffers));
+    }
+
+    //a single buffer without address or ancillary data needs no msghdr, plain send(2)
+    template<typename Arg>
+    inline SendMsgResult sendmsg(int fd, int flags, Arg&& pod){
+        const struct iovec iov = make_iovec(pod);
+        int lerrno = 0;
+        int nwritten = ::send(fd, iov.iov_base, iov.iov_len, flags);
+        if (nwritten == -1){
+            lerrno = errno;
+        }
+        return SendMsgResult((size_t) nwritten == iov.iov_len, lerrno, nwritten);
     }
 
     template<typename... Args>
     inline SendMsgResult sendmsg_with_ancillary(int fd, int flags, const void *ancillary_data, const size_t nancillary_size, Args&&... pods){
         auto buffers = make_iovec_array(std::forward<Args>(pods)...);
-        return unistd::sendmsgv(fd, ancillary_data, nancillary_size, buffers.data(), buffers.size(), flags, nullptr, 0);
+        return mpsl::sendmsgv(fd, ancillary_data, nancillary_size, buffers.data(), buffers.size(), flags, nullptr, 0, iovec_array_nbytes<Args...>(buffers));
     }
 
     template<typename sockaddr_t, typename... Args>
     inline SendMsgResult sendmsg_to(int fd, int flags, const sockaddr_t &sockaddr, Args&&... pods){
         auto buffers = make_iovec_array(std::forward<Args>(pods)...);
-        return unistd::sendmsgv(fd, nullptr, 0, buffers.data(), buffers.size(), flags, &sockaddr, sizeof(sockaddr_t));
+        return mpsl::sendmsgv(fd, nullptr, 0, buffers.data(), buffers.size(), flags, &sockaddr, sizeof(sockaddr_t), iovec_array_nbytes<Args...>(buffers));
+    }
+
+    //a single buffer to an address needs no msghdr, plain sendto(2)
+    template<typename sockaddr_t, typename Arg>
+    inline SendMsgResult sendmsg_to(int fd, int flags, const sockaddr_t &sockaddr, Arg&& pod){
+        const struct iovec iov = make_iovec(pod);
+        int lerrno = 0;
+        int nwritten = ::sendto(fd, iov.iov_base, iov.iov_len, flags, (const struct sockaddr *) &sockaddr, sizeof(sockaddr_t));
+        if (nwritten == -1){
+            lerrno = errno;
+        }
+        return SendMsgResult((size_t) nwritten == iov.iov_len, lerrno, nwritten);
     }
 
     inline struct sockaddr_un make_sockaddr_un(const std::string &path){
@@ -406,3 +433,5 @@ namespace mpsl{
         return str;
     }
 }
+
+#endif
@@ -24,6 +24,10 @@ namespace mpsl{
         inline bool operator!=(const int evalue) const{
             return code().value() != evalue;
         }
+        //the operation could not make (further) progress without blocking, retry on readiness
+        inline bool would_block() const{
+            return !success && (code().value() == EAGAIN || code().value() == EWOULDBLOCK);
+        }
         inline BaseResult():success(false), error_code(0, std::generic_category()){}
         inline BaseResult(bool success, int errnum):success(success), error_code(errnum, std::generic_category()){}
     };